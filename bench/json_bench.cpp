@@ -0,0 +1,129 @@
+//
+// Compares nlohmann::json DOM serialization with JsonWriter
+// for a Discord webhook payload and a status array.
+//
+#include "../src/jsonwriter.h"
+#include "json.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+static size_t allocCount;
+
+void *operator new(size_t size)
+{
+	allocCount++;
+	void *p = malloc(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+void operator delete(void *p) noexcept {
+	free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+using namespace nlohmann;
+
+static const std::string content = "A new player joined the lobby";
+static const std::string title = "Player **Tom** joined";
+static const std::string text = "2 players waiting in room \"Beginners\" \xe2\x80\x94 come and join!";
+
+static std::string domWebhook()
+{
+	json embeds;
+	for (int i = 0; i < 10; i++)
+		embeds.push_back({
+			{ "author",
+				{
+					{ "name", "ChuChu Rocket!" },
+					{ "icon_url", "https://dcnet.flyca.st/gamepic/chuchu.jpg" }
+				},
+			},
+			{ "title", title },
+			{ "description", text },
+			{ "color", 9118205 },
+		});
+	json jnotif = {
+		{ "content", content },
+		{ "embeds", embeds },
+	};
+	return jnotif.dump(4, ' ', false, json::error_handler_t::replace);
+}
+
+static const std::string& writerWebhook()
+{
+	static std::string buffer;
+	JsonWriter writer(buffer);
+	writer.beginObject()
+		.field("content", content)
+		.key("embeds").beginArray();
+	for (int i = 0; i < 10; i++)
+		writer.beginObject()
+			.key("author").beginObject()
+				.field("name", "ChuChu Rocket!")
+				.field("icon_url", "https://dcnet.flyca.st/gamepic/chuchu.jpg")
+			.endObject()
+			.field("title", title)
+			.field("description", text)
+			.field("color", 9118205)
+		.endObject();
+	writer.endArray().endObject();
+	return buffer;
+}
+
+static std::string domStatus()
+{
+	json statusArray;
+	for (int i = 0; i < 30; i++)
+		statusArray.push_back({
+			{ "gameId", "game" + std::to_string(i) },
+			{ "timestamp", 1767225600 },
+			{ "playerCount", i },
+			{ "gameCount", i / 2 },
+		});
+	return statusArray.dump(4);
+}
+
+static const std::string& writerStatus()
+{
+	static std::string buffer;
+	JsonWriter writer(buffer);
+	writer.beginArray();
+	for (int i = 0; i < 30; i++)
+		writer.beginObject()
+			.field("gameId", "game" + std::to_string(i))
+			.field("timestamp", (int64_t)1767225600)
+			.field("playerCount", i)
+			.field("gameCount", i / 2)
+		.endObject();
+	writer.endArray();
+	return buffer;
+}
+
+template<typename F>
+static void bench(const char *name, F f)
+{
+	constexpr int Iterations = 20000;
+	size_t bytes = f().size();	// warm up
+	allocCount = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+		bytes = f().size();
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("%-20s %6zu bytes %8.1f allocs/op %8.0f ns/op\n", name, bytes, (double)allocCount / Iterations,
+			(double)ns / Iterations);
+}
+
+int main()
+{
+	bench("webhook (json)", domWebhook);
+	bench("webhook (writer)", writerWebhook);
+	bench("status (json)", domStatus);
+	bench("status (writer)", writerStatus);
+	return 0;
+}
@@ -0,0 +1,59 @@
+//
+// Measures the notification pipeline (queue, batching, serialization and delivery)
+// with one or several in-memory sinks.
+//
+#include "../src/dispatcher.h"
+#include "../src/sink.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+static void bench(const char *name, const std::vector<std::string>& urls)
+{
+	constexpr int Count = 200000;
+	std::vector<std::unique_ptr<Sink>> sinks;
+	for (const auto& url : urls)
+		sinks.push_back(createSink(url, RetryPolicy()));
+	DispatcherOptions options;
+	options.queueSize = 4096;
+	options.overflow = OverflowPolicy::Block;
+	options.batchWindow = std::chrono::milliseconds(0);
+	size_t bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	{
+		Dispatcher dispatcher(options, urls, [&sinks](Dispatcher::Route& route, std::vector<PendingNotif>& batch) {
+			thread_local std::vector<std::string> payloads;
+			Sink& sink = *sinks[route.index];
+			sink.serialize(batch, payloads);
+			for (const auto& payload : payloads)
+				sink.send(route, payload);
+		});
+		for (int i = 0; i < Count; i++)
+		{
+			PendingNotif p;
+			p.gameId = "chuchu";
+			p.notif.content = "Player" + std::to_string(i % 100) + " joined the lobby";
+			p.notif.embed.title = "Lobby";
+			p.notif.embed.text = "3 players waiting";
+			dispatcher.enqueue(i % urls.size(), std::move(p));
+		}
+	}
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	size_t payloads = 0;
+	for (const auto& url : urls)
+		for (const auto& payload : MemorySink::take(url.substr(7)))
+		{
+			bytes += payload.size();
+			payloads++;
+		}
+	printf("%-24s %8.0f ns/notif %8zu payloads %10zu bytes\n", name, (double)ns / Count, payloads, bytes);
+}
+
+int main()
+{
+	bench("memory (json)", { "memory:a" });
+	bench("memory x4 (json)", { "memory:a", "memory:b", "memory:c", "memory:d" });
+	return 0;
+}
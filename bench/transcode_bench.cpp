@@ -0,0 +1,84 @@
+//
+// Measures Shift-JIS and Latin-1 to UTF-8 conversion of lobby chat lines
+// and compares the table-driven transcoder with iconv.
+//
+#include "encoding.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iconv.h>
+#include <string>
+#include <vector>
+
+// Typical lobby traffic: mostly short Japanese lines with ASCII names and numbers
+static const std::vector<std::string> sjisChat = {
+	"\x82\xb1\x82\xf1\x82\xc9\x82\xbf\x82\xcd",		// こんにちは
+	"Ragol \x82\xc9\x8d\x73\x82\xab\x82\xdc\x82\xb5\x82\xe5\x82\xa4\x81\x49",	// Ragol に行きましょう！
+	"GG! \x82\xe0\x82\xa4\x88\xea\x89\xf1?",			// GG! もう一回?
+	"Player1 joined the lobby",
+	"\x83\x8c\x83\x78\x83\x8b 42 \x82\xcc\x83\x6e\x83\x93\x83\x5e\x81\x5b\x82\xf0\x95\xe5\x8f\x57\x92\x86",	// レベル 42 のハンターを募集中
+	"\xb6\xc0\xb6\xc5 \xc3\xbd\xc4",					// ｶﾀｶﾅ ﾃｽﾄ
+	"brb 5 min",
+};
+static const std::vector<std::string> latin1Chat = {
+	"Salut \xe0 tous, on lance une partie ?",
+	"J'arrive dans 2 minutes, d\xe9sol\xe9",
+	"Player1 joined the lobby",
+	"\xa1Vamos! \xbfQui\xe9n juega?",
+};
+
+template<typename F>
+static void bench(const char *name, const std::vector<std::string>& lines, F f)
+{
+	constexpr int Iterations = 200000;
+	std::string out;
+	size_t bytes = 0;
+	for (const auto& line : lines)
+		bytes += line.size();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+		for (const auto& line : lines)
+			f(line, out);
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("%-20s %8.1f ns/line %8.1f MB/s\n", name, (double)ns / Iterations / lines.size(),
+			(double)bytes * Iterations / ns * 1000.0);
+}
+
+static void iconvConvert(iconv_t cd, const std::string& line, std::string& out)
+{
+	out.resize(line.size() * 3);
+	char *in = (char *)line.data();
+	size_t inLeft = line.size();
+	char *o = out.data();
+	size_t outLeft = out.size();
+	iconv(cd, &in, &inLeft, &o, &outLeft);
+	out.resize(out.size() - outLeft);
+}
+
+int main()
+{
+	bench("sjis (table)", sjisChat, [](const std::string& line, std::string& out) {
+		out.clear();
+		appendUtf8(out, line, TextEncoding::ShiftJis);
+	});
+	iconv_t cd = iconv_open("UTF-8", "CP932");
+	if (cd != (iconv_t)-1)
+	{
+		bench("sjis (iconv)", sjisChat, [cd](const std::string& line, std::string& out) {
+			iconvConvert(cd, line, out);
+		});
+		iconv_close(cd);
+	}
+	bench("latin1 (table)", latin1Chat, [](const std::string& line, std::string& out) {
+		out.clear();
+		appendUtf8(out, line, TextEncoding::Latin1);
+	});
+	cd = iconv_open("UTF-8", "ISO-8859-1");
+	if (cd != (iconv_t)-1)
+	{
+		bench("latin1 (iconv)", latin1Chat, [cd](const std::string& line, std::string& out) {
+			iconvConvert(cd, line, out);
+		});
+		iconv_close(cd);
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "asio.hpp"
+#include "shared_this.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+struct AsyncHttpResult
+{
+	// CURLcode of the transfer. 0 if the request reached the server.
+	int curlCode = 0;
+	// HTTP status code, 0 if no response was received
+	long status = 0;
+	std::string body;
+
+	bool ok() const {
+		return curlCode == 0 && status >= 200 && status < 300;
+	}
+};
+
+//
+// Non-blocking http client driven by an asio io_context.
+// Requests are multiplexed on a single curl multi handle whose sockets and timers
+// are watched by the io_context, so any number of concurrent requests run on the
+// io_context thread(s). Completion handlers are posted to the io_context.
+// post() and patch() can be called from any thread.
+//
+class AsyncHttp : public SharedThis<AsyncHttp>
+{
+public:
+	using Handler = std::function<void(const AsyncHttpResult&)>;
+
+	~AsyncHttp();
+
+	void post(const std::string& url, std::string body, const std::string& contentType, Handler handler);
+	void patch(const std::string& url, std::string body, const std::string& contentType, Handler handler);
+	// Sets the connection and whole request deadlines of the next requests.
+	// 10 and 30 seconds by default, as for Http. A zero duration means no limit.
+	// Can be called from any thread.
+	void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds timeout) {
+		connectTimeoutMs = connectTimeout.count();
+		timeoutMs = timeout.count();
+	}
+	// Number of requests in progress
+	size_t pending() const {
+		return requestCount;
+	}
+
+private:
+	struct Request;
+	struct Socket;
+	using CURLM = void;
+	using curl_socket_t = int;
+
+	AsyncHttp(asio::io_context& io);
+	void send(const char *method, const std::string& url, std::string&& body, const std::string& contentType,
+			Handler&& handler);
+	void start(std::unique_ptr<Request> request);
+	void socketAction(curl_socket_t fd, int events);
+	void checkCompleted();
+	void watch(const std::shared_ptr<Socket>& socket, bool write);
+	void onTimeout(const asio::error_code& ec);
+
+	static int socketCallback(void *easy, curl_socket_t fd, int what, void *userp, void *socketp);
+	static int timerCallback(CURLM *multi, long timeoutMs, void *userp);
+
+	asio::io_context& io;
+	asio::steady_timer timer;
+	CURLM *multi = nullptr;
+	std::map<curl_socket_t, std::shared_ptr<Socket>> sockets;
+	// requests added to the multi handle
+	std::set<Request *> active;
+	std::atomic<size_t> requestCount { 0 };
+	// milliseconds, read by send() from any thread
+	std::atomic<int64_t> connectTimeoutMs { 10000 };
+	std::atomic<int64_t> timeoutMs { 30000 };
+
+	friend class SharedThis<AsyncHttp>;
+};
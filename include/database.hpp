@@ -15,11 +15,13 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
+#pragma once
 #include <sqlite3.h>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 
 class UniqueConstraintViolation : public std::runtime_error
 {
@@ -112,6 +114,12 @@ public:
 		if (sqlite3_bind_int(stmt, idx, v) != SQLITE_OK)
 			throwSqlError(db);
 	}
+	void bind(int idx, int64_t v)
+	{
+		checkReset();
+		if (sqlite3_bind_int64(stmt, idx, v) != SQLITE_OK)
+			throwSqlError(db);
+	}
 	void bind(int idx, const std::string& s)
 	{
 		checkReset();
@@ -139,6 +147,9 @@ public:
 	int getIntColumn(int idx) {
 		return sqlite3_column_int(stmt, idx);
 	}
+	int64_t getInt64Column(int idx) {
+		return sqlite3_column_int64(stmt, idx);
+	}
 	std::string getStringColumn(int idx) {
 		return std::string((const char *)sqlite3_column_text(stmt, idx));
 	}
@@ -0,0 +1,33 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Starts loading the configuration files and game catalog, and initializing the http client
+// in the background. Calling it at startup avoids delaying the first notification or status update.
+// Only the first call has an effect.
+void dcserverInit(void);
+// Waits for the initialization to complete, starting it if needed, and returns how long it took in ms
+int dcserverWaitInit(void);
+
+#ifdef __cplusplus
+}
+#endif
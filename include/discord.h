@@ -17,13 +17,33 @@
 */
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+enum DiscordPriority {
+	DISCORD_PRIORITY_LOW,
+	DISCORD_PRIORITY_NORMAL,
+	DISCORD_PRIORITY_HIGH,
+};
+
 void discordSetWebhook(const char *url);
 int discordNotif(const char *gameId, const char *content, const char *embedTitle, const char *embedText);
+int discordNotifPriority(const char *gameId, const char *content, const char *embedTitle, const char *embedText,
+		enum DiscordPriority priority);
+// Sends a notification built from a template with count named arguments
+int discordTemplateNotif(const char *gameId, const char *templateName,
+		const char * const *argNames, const char * const *argValues, int count);
+// Creates or updates the message showing the status of a game
+int discordStatusMessage(const char *gameId, const char *content, const char *embedTitle, const char *embedText);
+// Returns an escaped copy of s that must be freed by the caller
 char *discordEscape(const char *s);
+// Escapes s into buf and returns the length of the escaped string, not counting the terminating null.
+// At most bufsize - 1 characters are written and buf is always null-terminated if bufsize isn't 0.
+// A return value of bufsize or more means the output was truncated.
+size_t discordEscapeInto(const char *s, char *buf, size_t bufsize);
 
 #ifdef __cplusplus
 }
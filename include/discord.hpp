@@ -19,9 +19,20 @@
 #include <string>
 #include <string_view>
 #include <stdexcept>
+#include <cstdint>
+#include <initializer_list>
+
+enum class NotifPriority
+{
+	Low,
+	Normal,
+	High,
+};
 
 struct Notif
 {
+	// Low priority notifications are dropped first when the queue is full
+	NotifPriority priority = NotifPriority::Normal;
 	std::string content;
 	struct {
 		std::string title;
@@ -29,6 +40,24 @@ struct Notif
 	} embed;
 };
 
+// Named argument of a notification template
+struct TemplateArg
+{
+	TemplateArg(std::string_view name, std::string_view value)
+		: name(name), value(value) {}
+	TemplateArg(std::string_view name, const char *value)
+		: name(name), value(value) {}
+	TemplateArg(std::string_view name, int64_t number)
+		: name(name), number(number), isNumber(true) {}
+	TemplateArg(std::string_view name, int number)
+		: name(name), number(number), isNumber(true) {}
+
+	std::string_view name;
+	std::string_view value;
+	int64_t number = 0;
+	bool isNumber = false;
+};
+
 class DiscordException : public std::runtime_error
 {
 public:
@@ -41,5 +70,16 @@ public:
 };
 
 void discordSetWebhook(std::string_view url);
+// Banned words of the word-filter list of discord.conf are masked in notifications,
+// whose text is markdown: player text must have been escaped with discordEscape().
+// Template arguments are masked before they are escaped.
 void discordNotif(const std::string& gameId, const Notif& notif);
+// Sends a notification built from a template of the templates file.
+// Throws DiscordException if the template doesn't exist.
+void discordTemplateNotif(const std::string& gameId, std::string_view templateName,
+		std::initializer_list<TemplateArg> args, NotifPriority priority = NotifPriority::Normal);
+// Creates or updates the message showing the status of a game.
+// Only the latest update is sent if several are pending.
+void discordStatusMessage(const std::string& gameId, const Notif& notif);
+// Escapes Discord markdown characters. Doesn't mask banned words.
 std::string discordEscape(std::string_view str);
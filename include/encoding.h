@@ -0,0 +1,39 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum DcEncoding {
+	DC_ENCODING_UTF8,
+	DC_ENCODING_SHIFT_JIS,
+	DC_ENCODING_LATIN1,
+};
+
+// Converts s to UTF-8 into buf and returns the length of the converted string, not counting the terminating null.
+// At most bufsize - 1 bytes are written and buf is always null-terminated if bufsize isn't 0.
+// A return value of bufsize or more means the output was truncated. UTF-8 sequences are never split.
+// Invalid characters are replaced by U+FFFD.
+size_t transcodeToUtf8(enum DcEncoding encoding, const char *s, char *buf, size_t bufsize);
+
+#ifdef __cplusplus
+}
+#endif
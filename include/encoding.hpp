@@ -0,0 +1,33 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <string>
+#include <string_view>
+
+enum class TextEncoding
+{
+	Utf8,
+	ShiftJis,	// Windows code page 932
+	Latin1,		// ISO-8859-1
+};
+
+// Accepts utf-8, shift-jis, sjis, cp932, latin1 and iso-8859-1. Defaults to UTF-8.
+TextEncoding parseEncoding(std::string_view name);
+// Invalid characters are replaced by U+FFFD. UTF-8 strings are returned unchanged.
+std::string toUtf8(std::string_view s, TextEncoding encoding);
+void appendUtf8(std::string& out, std::string_view s, TextEncoding encoding);
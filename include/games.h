@@ -0,0 +1,31 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns the name of a game or NULL if unknown
+const char *gameName(const char *gameId);
+// Returns the thumbnail URL of a game or NULL if unknown
+const char *gameThumbnail(const char *gameId);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,259 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "asynchttp.hpp"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <curl/curl.h>
+
+struct AsyncHttp::Request
+{
+	CURL *curl = nullptr;
+	curl_slist *headers = nullptr;
+	std::string body;
+	AsyncHttpResult result;
+	Handler handler;
+
+	~Request() {
+		curl_slist_free_all(headers);
+		if (curl != nullptr)
+			curl_easy_cleanup(curl);
+	}
+
+	static size_t writeCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+	{
+		((Request *)userdata)->result.body.append(buffer, size * nitems);
+		return size * nitems;
+	}
+};
+
+// A socket opened by curl and watched by asio. The descriptor is released, not closed,
+// when curl is done with it.
+struct AsyncHttp::Socket
+{
+	Socket(asio::io_context& io, curl_socket_t fd)
+		: desc(io, fd), fd(fd) {
+	}
+	~Socket() {
+		close();
+	}
+
+	// Stops watching the socket. Pending waits complete with operation_aborted.
+	void close()
+	{
+		if (desc.is_open())
+		{
+			asio::error_code ec;
+			desc.cancel(ec);
+			desc.release();
+		}
+	}
+
+	asio::posix::stream_descriptor desc;
+	curl_socket_t fd;
+	// CURL_POLL_* events curl is interested in
+	int what = 0;
+	bool reading = false;
+	bool writing = false;
+};
+
+AsyncHttp::AsyncHttp(asio::io_context& io)
+	: io(io), timer(io)
+{
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	multi = curl_multi_init();
+	if (multi == nullptr)
+		throw std::runtime_error("can't create curl multi handle");
+	curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, socketCallback);
+	curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+	curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, timerCallback);
+	curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+}
+
+AsyncHttp::~AsyncHttp()
+{
+	// Abort the requests in progress without calling their handlers
+	for (Request *request : active)
+	{
+		curl_multi_remove_handle(multi, request->curl);
+		delete request;
+	}
+	sockets.clear();
+	curl_multi_cleanup(multi);
+}
+
+void AsyncHttp::post(const std::string& url, std::string body, const std::string& contentType, Handler handler) {
+	send("POST", url, std::move(body), contentType, std::move(handler));
+}
+
+void AsyncHttp::patch(const std::string& url, std::string body, const std::string& contentType, Handler handler) {
+	send("PATCH", url, std::move(body), contentType, std::move(handler));
+}
+
+void AsyncHttp::send(const char *method, const std::string& url, std::string&& body, const std::string& contentType,
+		Handler&& handler)
+{
+	std::unique_ptr<Request> request = std::make_unique<Request>();
+	request->curl = curl_easy_init();
+	if (request->curl == nullptr)
+		throw std::runtime_error("can't create curl handle");
+	request->body = std::move(body);
+	request->handler = std::move(handler);
+	CURL *curl = request->curl;
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_USERAGENT, "DCNet-DiscordWebhook");
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)connectTimeoutMs.load());
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)timeoutMs.load());
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	if (!contentType.empty()) {
+		std::string ctype = "Content-Type: " + contentType;
+		request->headers = curl_slist_append(request->headers, ctype.c_str());
+	}
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request->headers);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->body.data());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)request->body.size());
+	if (strcmp(method, "POST") != 0)
+		curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Request::writeCallback);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, request.get());
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, request.get());
+
+	requestCount++;
+	// the multi handle is only used from the io_context
+	asio::post(io, [self = shared_from_this(), req = request.release()]() {
+		self->start(std::unique_ptr<Request>(req));
+	});
+}
+
+void AsyncHttp::start(std::unique_ptr<Request> request)
+{
+	CURLMcode rc = curl_multi_add_handle(multi, request->curl);
+	if (rc != CURLM_OK)
+	{
+		fprintf(stderr, "ERROR: curl_multi_add_handle: %s\n", curl_multi_strerror(rc));
+		request->result.curlCode = CURLE_FAILED_INIT;
+		requestCount--;
+		request->handler(request->result);
+		return;
+	}
+	// owned by the multi handle until completion
+	active.insert(request.release());
+}
+
+void AsyncHttp::socketAction(curl_socket_t fd, int events)
+{
+	int running;
+	curl_multi_socket_action(multi, fd, events, &running);
+	checkCompleted();
+}
+
+void AsyncHttp::checkCompleted()
+{
+	CURLMsg *msg;
+	int count;
+	while ((msg = curl_multi_info_read(multi, &count)) != nullptr)
+	{
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+		CURL *curl = msg->easy_handle;
+		Request *request;
+		curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&request);
+		request->result.curlCode = msg->data.result;
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &request->result.status);
+		curl_multi_remove_handle(multi, curl);
+		active.erase(request);
+		requestCount--;
+		asio::post(io, [request = std::shared_ptr<Request>(request)]() {
+			request->handler(request->result);
+		});
+	}
+}
+
+void AsyncHttp::watch(const std::shared_ptr<Socket>& socket, bool write)
+{
+	bool& waiting = write ? socket->writing : socket->reading;
+	if (waiting)
+		return;
+	waiting = true;
+	auto handler = [self = shared_from_this(), socket, write](const asio::error_code& ec)
+	{
+		(write ? socket->writing : socket->reading) = false;
+		auto it = self->sockets.find(socket->fd);
+		if (ec || it == self->sockets.end() || it->second != socket)
+			// cancelled or no longer used by curl
+			return;
+		self->socketAction(socket->fd, write ? CURL_CSELECT_OUT : CURL_CSELECT_IN);
+		// watch again if curl is still interested
+		it = self->sockets.find(socket->fd);
+		if (it != self->sockets.end() && it->second == socket
+				&& (socket->what & (write ? CURL_POLL_OUT : CURL_POLL_IN)) != 0)
+			self->watch(socket, write);
+	};
+	socket->desc.async_wait(write ? asio::posix::stream_descriptor::wait_write : asio::posix::stream_descriptor::wait_read,
+			handler);
+}
+
+int AsyncHttp::socketCallback(CURL *easy, curl_socket_t fd, int what, void *userp, void *socketp)
+{
+	AsyncHttp *self = (AsyncHttp *)userp;
+	if (what == CURL_POLL_REMOVE)
+	{
+		auto it = self->sockets.find(fd);
+		if (it != self->sockets.end())
+		{
+			// curl will close the socket
+			it->second->close();
+			self->sockets.erase(it);
+		}
+		return 0;
+	}
+	std::shared_ptr<Socket>& socket = self->sockets[fd];
+	if (socket == nullptr)
+		socket = std::make_shared<Socket>(self->io, fd);
+	socket->what = what;
+	if (what & CURL_POLL_IN)
+		self->watch(socket, false);
+	if (what & CURL_POLL_OUT)
+		self->watch(socket, true);
+	return 0;
+}
+
+int AsyncHttp::timerCallback(CURLM *multi, long timeoutMs, void *userp)
+{
+	AsyncHttp *self = (AsyncHttp *)userp;
+	if (timeoutMs < 0) {
+		self->timer.cancel();
+		return 0;
+	}
+	// Don't call curl back from within the callback
+	self->timer.expires_after(std::chrono::milliseconds(timeoutMs));
+	self->timer.async_wait([weak = self->weak_from_this()](const asio::error_code& ec) {
+		auto self = weak.lock();
+		if (self != nullptr)
+			self->onTimeout(ec);
+	});
+	return 0;
+}
+
+void AsyncHttp::onTimeout(const asio::error_code& ec)
+{
+	if (!ec)
+		socketAction(CURL_SOCKET_TIMEOUT, 0);
+}
@@ -0,0 +1,301 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "catalog.h"
+#include "games.h"
+#include "hash.h"
+#include "builtin_games.h"
+#include "json.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <stdio.h>
+
+#ifndef CONFDIR
+#define CONFDIR "/usr/local/etc/dcnet"
+#endif
+#ifndef STATEDIR
+#define STATEDIR "/var/local/lib/dcnet"
+#endif
+#define GAMES_FILE CONFDIR "/games.json"
+#ifdef DATADIR
+// location of the override file before the catalog was compiled in
+#define OLD_GAMES_FILE DATADIR "/games.json"
+#endif
+#define CONF_FILE CONFDIR "/catalog.conf"
+#define CACHE_FILE STATEDIR "/games-cache.json"
+
+using namespace nlohmann;
+
+GameCatalog GameCatalog::parse(std::istream& stream)
+{
+	json games = json::parse(stream);
+	struct Entry {
+		std::string id;
+		std::string name;
+		std::string thumbnail;
+	};
+	std::vector<Entry> entries;
+	size_t storageSize = 0;
+	for (const auto& [id, game] : games.items())
+	{
+		auto name = game.find("name");
+		auto thumbnail = game.find("thumbnail");
+		if (name == game.end() || !name->is_string() || thumbnail == game.end() || !thumbnail->is_string())
+			continue;
+		entries.push_back({ id, name->get<std::string>(), thumbnail->get<std::string>() });
+		storageSize += id.length() + entries.back().name.length() + entries.back().thumbnail.length() + 3;
+	}
+
+	GameCatalog catalog;
+	catalog.strings = std::make_unique<char[]>(storageSize);
+	char *p = catalog.strings.get();
+	auto store = [&p](const std::string& s) {
+		memcpy(p, s.c_str(), s.length() + 1);
+		std::string_view sv(p, s.length());
+		p += s.length() + 1;
+		return sv;
+	};
+	catalog.games.reserve(entries.size());
+	for (const Entry& entry : entries)
+		catalog.games.push_back({ store(entry.id), store(entry.name), store(entry.thumbnail) });
+
+	size_t slotCount = 4;
+	while (slotCount < catalog.games.size() * 2)
+		slotCount <<= 1;
+	catalog.slots.resize(slotCount);
+	for (size_t i = 0; i < catalog.games.size(); i++)
+	{
+		size_t slot = hashSlot(fnv1a(catalog.games[i].id), slotCount);
+		while (catalog.slots[slot] != 0)
+			slot = (slot + 1) & (slotCount - 1);
+		catalog.slots[slot] = i + 1;
+	}
+	return catalog;
+}
+
+const GameInfo *GameCatalog::find(std::string_view id) const
+{
+	if (slots.empty())
+		return nullptr;
+	const size_t mask = slots.size() - 1;
+	for (size_t slot = hashSlot(fnv1a(id), slots.size()); slots[slot] != 0; slot = (slot + 1) & mask)
+	{
+		const GameInfo& game = games[slots[slot] - 1];
+		if (game.id == id)
+			return &game;
+	}
+	return nullptr;
+}
+
+RemoteCatalog::RemoteCatalog(const std::string& url, const std::string& cachePath)
+	: url(url), cachePath(cachePath)
+{
+}
+
+RemoteCatalog::~RemoteCatalog()
+{
+	stopToken.cancel();
+	if (thread.joinable())
+		thread.join();
+}
+
+void RemoteCatalog::loadCache()
+{
+	std::ifstream ifs(cachePath);
+	if (ifs.fail())
+		return;
+	std::stringstream json;
+	json << ifs.rdbuf();
+	try {
+		install(GameCatalog::parse(json));
+	} catch (const std::exception& e) {
+		fprintf(stderr, "%s: %s\n", cachePath.c_str(), e.what());
+		return;
+	}
+	currentHash = fnv1a(json.str());
+	// validators of the cached version
+	std::ifstream meta(cachePath + ".meta");
+	std::getline(meta, validators.etag);
+	std::getline(meta, validators.lastModified);
+}
+
+bool RemoteCatalog::refresh()
+{
+	thread_local std::string json;
+	// a conditional request is pointless without a current version
+	HttpValidators newValidators = get() != nullptr ? validators : HttpValidators();
+	HttpOptions options;
+	options.cancelToken = &stopToken;
+	if (!Http(options).get(url, ResponseSink::capture(json, 16 * 1024 * 1024), &newValidators))
+		// 304 Not Modified
+		return false;
+	uint64_t hash = fnv1a(json);
+	if (get() != nullptr && hash == currentHash)
+	{
+		// servers without validators send the same catalog again
+		validators = newValidators;
+		return false;
+	}
+	std::istringstream stream(json);
+	install(GameCatalog::parse(stream));
+	currentHash = hash;
+	validators = newValidators;
+	try {
+		saveCache(json);
+	} catch (const std::exception& e) {
+		fprintf(stderr, "%s: %s\n", cachePath.c_str(), e.what());
+	}
+	return true;
+}
+
+void RemoteCatalog::install(GameCatalog&& catalog)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	versions.push_back(std::make_unique<GameCatalog>(std::move(catalog)));
+	current.store(versions.back().get(), std::memory_order_release);
+}
+
+void RemoteCatalog::saveCache(const std::string& json)
+{
+	if (cachePath.empty())
+		return;
+	// write then rename so that the cache is never partially written
+	auto write = [](const std::string& path, const std::string& content) {
+		std::string tmpPath = path + ".tmp";
+		std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+		ofs << content;
+		ofs.close();
+		if (ofs.fail() || rename(tmpPath.c_str(), path.c_str()) != 0)
+			throw std::runtime_error("can't write " + path);
+	};
+	write(cachePath, json);
+	write(cachePath + ".meta", validators.etag + '\n' + validators.lastModified + '\n');
+}
+
+void RemoteCatalog::start(std::chrono::seconds interval)
+{
+	thread = std::thread([this, interval]() {
+		do {
+			try {
+				if (refresh())
+					fprintf(stderr, "Game catalog updated: %zu games\n", get()->size());
+			} catch (const std::exception& e) {
+				if (!stopToken.isCancelled())
+					fprintf(stderr, "Game catalog refresh failed: %s\n", e.what());
+			}
+		} while (stopToken.sleepFor(interval));
+	});
+}
+
+static std::unique_ptr<RemoteCatalog> loadRemote()
+{
+	std::ifstream ifs(CONF_FILE);
+	if (ifs.fail())
+		return nullptr;
+	Config config = loadConfig(ifs);
+	if (config.count("games-url") == 0 || config["games-url"].empty())
+		return nullptr;
+	std::string cachePath = CACHE_FILE;
+	if (config.count("cache-file") != 0)
+		cachePath = config["cache-file"].empty() ? "" : config["cache-file"][0];
+	int interval = 60 * 60;
+	if (config.count("refresh-interval") != 0 && !config["refresh-interval"].empty())
+		interval = std::max(60, atoi(config["refresh-interval"][0].c_str()));
+
+	auto catalog = std::make_unique<RemoteCatalog>(config["games-url"][0], cachePath);
+	catalog->loadCache();
+	catalog->start(std::chrono::seconds(interval));
+	return catalog;
+}
+
+const GameCatalog *remoteCatalog()
+{
+	static const std::unique_ptr<RemoteCatalog> catalog = loadRemote();
+	return catalog == nullptr ? nullptr : catalog->get();
+}
+
+static GameCatalog loadOverride()
+{
+	std::ifstream ifs(GAMES_FILE);
+	if (ifs.fail())
+	{
+#ifdef OLD_GAMES_FILE
+		if (std::ifstream(OLD_GAMES_FILE).good())
+			fprintf(stderr, OLD_GAMES_FILE " is ignored. Move local changes to " GAMES_FILE "\n");
+#endif
+		return {};
+	}
+	try {
+		return GameCatalog::parse(ifs);
+	} catch (const std::exception& e) {
+		fprintf(stderr, GAMES_FILE ": %s\n", e.what());
+		return {};
+	}
+}
+
+const GameCatalog& overrideCatalog()
+{
+	static const GameCatalog catalog = loadOverride();
+	return catalog;
+}
+
+static constexpr const GameInfo *findBuiltin(std::string_view gameId)
+{
+	unsigned idx = builtin::slots[hashSlot(fnv1a(gameId, builtin::HASH_BASIS), builtin::SLOT_COUNT)];
+	if (idx == 0 || builtin::games[idx - 1].id != gameId)
+		return nullptr;
+	return &builtin::games[idx - 1];
+}
+
+const GameInfo *findBuiltinGame(std::string_view gameId) {
+	return findBuiltin(gameId);
+}
+
+const GameInfo *findGame(std::string_view gameId)
+{
+	const GameInfo *game = overrideCatalog().find(gameId);
+	if (game == nullptr)
+	{
+		const GameCatalog *remote = remoteCatalog();
+		if (remote != nullptr)
+			game = remote->find(gameId);
+	}
+	if (game == nullptr)
+		game = findBuiltin(gameId);
+	return game;
+}
+
+extern "C"
+{
+
+const char *gameName(const char *gameId)
+{
+	const GameInfo *game = findGame(gameId);
+	return game == nullptr ? nullptr : game->name.data();
+}
+
+const char *gameThumbnail(const char *gameId)
+{
+	const GameInfo *game = findGame(gameId);
+	return game == nullptr ? nullptr : game->thumbnail.data();
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "games.hpp"
+#include "internal.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//
+// Immutable game catalog with allocation-free lookups.
+// All strings are stored contiguously and null-terminated, and
+// games are indexed by an open-addressing hash table.
+//
+class GameCatalog
+{
+public:
+	// Parses a games.json stream
+	static GameCatalog parse(std::istream& stream);
+
+	const GameInfo *find(std::string_view id) const;
+	size_t size() const {
+		return games.size();
+	}
+
+private:
+	std::unique_ptr<char[]> strings;
+	std::vector<GameInfo> games;
+	// index + 1 into games, 0 if empty
+	std::vector<uint32_t> slots;
+};
+
+//
+// Game catalog downloaded from a url and kept up to date.
+// Conditional requests are used so that the catalog is only downloaded when it has changed.
+// The last version is cached in a file to be available immediately on startup.
+//
+class RemoteCatalog
+{
+public:
+	RemoteCatalog(const std::string& url, const std::string& cachePath);
+	~RemoteCatalog();
+
+	// Installs the cached version, if any
+	void loadCache();
+	// Downloads the catalog if it has changed. Returns true if a new version has been installed.
+	bool refresh();
+	// Refreshes the catalog now and then periodically in a background thread
+	void start(std::chrono::seconds interval);
+
+	// Latest version, or nullptr if none is available.
+	// Previous versions are kept so that the game info returned by find() remains valid.
+	// A version is only added when the downloaded catalog differs from the current one,
+	// so they grow with the number of catalog updates published while the process runs.
+	const GameCatalog *get() const {
+		return current.load(std::memory_order_acquire);
+	}
+
+private:
+	void install(GameCatalog&& catalog);
+	void saveCache(const std::string& json);
+
+	const std::string url;
+	const std::string cachePath;
+	HttpValidators validators;
+	std::atomic<const GameCatalog *> current { nullptr };
+	std::vector<std::unique_ptr<GameCatalog>> versions;
+	// hash of the json of the current version
+	uint64_t currentHash = 0;
+	std::mutex mutex;
+	// cancels the refresh in progress and stops the thread
+	CancelToken stopToken;
+	std::thread thread;
+};
+
+// Catalog downloaded from the games-url of CONFDIR/catalog.conf, or nullptr
+const GameCatalog *remoteCatalog();
+
+// Optional catalog loaded from CONFDIR/games.json that overrides and extends the builtin one
+const GameCatalog& overrideCatalog();
+// Game catalog compiled from share/games.json
+const GameInfo *findBuiltinGame(std::string_view gameId);
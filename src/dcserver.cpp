@@ -0,0 +1,69 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "dcserver.h"
+#include "internal.h"
+#include "catalog.h"
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdio.h>
+
+static std::once_flag initFlag;
+// load time in ms
+static std::shared_future<int> initResult;
+
+template<typename F>
+static void initStep(const char *name, F f)
+{
+	try {
+		f();
+	} catch (const std::exception& e) {
+		fprintf(stderr, "%s initialization failed: %s\n", name, e.what());
+	}
+}
+
+static int load()
+{
+	auto start = std::chrono::steady_clock::now();
+	initStep("Http", Http::warmUp);
+	initStep("Game catalog", overrideCatalog);
+	initStep("Remote game catalog", remoteCatalog);
+	initStep("Discord", discordInit);
+	initStep("Status", statusInit);
+	int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "dcserver initialized in %d ms\n", ms);
+	return ms;
+}
+
+extern "C"
+{
+
+void dcserverInit()
+{
+	std::call_once(initFlag, []() {
+		initResult = std::async(std::launch::async, load).share();
+	});
+}
+
+int dcserverWaitInit()
+{
+	dcserverInit();
+	return initResult.get();
+}
+
+}
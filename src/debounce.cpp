@@ -0,0 +1,127 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "debounce.h"
+#include "hash.h"
+#include <stdio.h>
+
+Debouncer::Debouncer(clock::duration window, Mode mode)
+	: window(window), mode(mode)
+{
+}
+
+Debouncer::Mode Debouncer::parseMode(std::string_view s)
+{
+	if (s == "suppress")
+		return Mode::Suppress;
+	if (s != "fold")
+		fprintf(stderr, "Unknown dedup mode: %.*s\n", (int)s.length(), s.data());
+	return Mode::Fold;
+}
+
+static uint64_t notifKey(const std::string& gameId, const Notif& notif)
+{
+	uint64_t h = fnv1a(gameId);
+	h = fnv1a(std::string_view("", 1), h);
+	return fnv1a(notif.embed.title, h);
+}
+
+void Debouncer::rotate(clock::time_point now)
+{
+	if (now < currentStart + window)
+		return;
+	auto fold = [this](Bucket& bucket) {
+		if (mode != Mode::Fold)
+			return;
+		for (auto& [key, entry] : bucket)
+		{
+			if (entry.repeats == 0)
+				continue;
+			Summary& summary = summaries.emplace_back();
+			summary.gameId = std::move(entry.gameId);
+			summary.notif = std::move(entry.notif);
+			summary.notif.embed.title += " ×" + std::to_string(entry.repeats);
+		}
+	};
+	fold(previous);
+	if (now < currentStart + 2 * window)
+	{
+		previous.swap(current);
+		previousFolds = currentFolds;
+		currentStart += window;
+	}
+	else
+	{
+		// both buckets have expired
+		fold(current);
+		previous.clear();
+		previousFolds = 0;
+		currentStart = now;
+	}
+	current.clear();
+	currentFolds = 0;
+}
+
+bool Debouncer::admit(const std::string& gameId, const Notif& notif, clock::time_point now)
+{
+	uint64_t key = notifKey(gameId, notif);
+	std::lock_guard<std::mutex> _(mutex);
+	rotate(now);
+	Bucket *bucket = &current;
+	auto it = current.find(key);
+	if (it == current.end())
+	{
+		it = previous.find(key);
+		if (it == previous.end())
+		{
+			Entry& entry = current[key];
+			if (mode == Mode::Fold)
+				entry.gameId = gameId;
+			return true;
+		}
+		bucket = &previous;
+	}
+	Entry& entry = it->second;
+	if (mode == Mode::Fold)
+	{
+		if (entry.repeats++ == 0)
+			(bucket == &current ? currentFolds : previousFolds)++;
+		entry.notif = notif;
+	}
+	return false;
+}
+
+std::vector<Debouncer::Summary> Debouncer::expired(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	rotate(now);
+	std::vector<Summary> ret;
+	ret.swap(summaries);
+	return ret;
+}
+
+Debouncer::clock::time_point Debouncer::nextExpiry() const
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (!summaries.empty())
+		return clock::time_point::min();
+	if (previousFolds != 0)
+		return currentStart + window;
+	if (currentFolds != 0)
+		return currentStart + 2 * window;
+	return clock::time_point::max();
+}
@@ -0,0 +1,84 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "discord.hpp"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//
+// Drops notifications repeated with the same game and embed title within a time window.
+// Notifications are kept in two hash sets: the current time bucket and the previous one,
+// so a repeat is detected for at least one window and at most two after the first notification.
+// In fold mode, repeats are counted and a summary with a "×N" suffix is
+// produced once the bucket of the first notification expires.
+//
+class Debouncer
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	enum class Mode {
+		Suppress,
+		Fold,
+	};
+
+	struct Summary
+	{
+		std::string gameId;
+		// last repeated notification with the number of repeats appended to its title
+		Notif notif;
+	};
+
+	Debouncer(clock::duration window, Mode mode);
+
+	// Returns true if the notification must be sent, false if it's a repeat
+	bool admit(const std::string& gameId, const Notif& notif, clock::time_point now = clock::now());
+	// Returns the summaries of folded repeats whose bucket has expired
+	std::vector<Summary> expired(clock::time_point now = clock::now());
+	// Time at which the next summary will be available, or time_point::max() if none
+	clock::time_point nextExpiry() const;
+
+	static Mode parseMode(std::string_view s);
+
+private:
+	struct Entry
+	{
+		std::string gameId;
+		Notif notif;
+		unsigned repeats = 0;
+	};
+	using Bucket = std::unordered_map<uint64_t, Entry>;
+
+	void rotate(clock::time_point now);
+
+	const clock::duration window;
+	const Mode mode;
+	mutable std::mutex mutex;
+	Bucket current;
+	Bucket previous;
+	clock::time_point currentStart {};
+	std::vector<Summary> summaries;
+	// number of entries with repeats in the previous and current buckets
+	size_t previousFolds = 0;
+	size_t currentFolds = 0;
+};
@@ -16,129 +16,608 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "discord.hpp"
+#include "discord.h"
 #include "strprintf.hpp"
-#include "json.hpp"
 #include "internal.h"
-#include <atomic>
-#include <thread>
-#include <chrono>
+#include "catalog.h"
+#include "debounce.h"
+#include "encoding.hpp"
+#include "dispatcher.h"
+#include "messageids.h"
+#include "outbox.h"
+#include "retry.h"
+#include "routing.h"
+#include "sink.h"
+#include "template.h"
+#include "wordfilter.h"
+#include "json.hpp"
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <stdio.h>
 #include <set>
+#include <algorithm>
+#include <memory>
+#include <time.h>
 
-#ifndef DATADIR
-#define DATADIR "/usr/local/share/dcnet"
-#endif
 #ifndef CONFDIR
 #define CONFDIR "/usr/local/etc/dcnet"
 #endif
-#define GAMES_FILE DATADIR "/games.json"
+#ifndef STATEDIR
+#define STATEDIR "/var/local/lib/dcnet"
+#endif
 #define CONF_FILE CONFDIR "/discord.conf"
+#define OUTBOX_FILE STATEDIR "/discord-outbox.db"
+#define MESSAGES_FILE STATEDIR "/discord-messages.db"
+#define TEMPLATES_FILE CONFDIR "/discord-templates.conf"
 
-using namespace nlohmann;
-static constexpr int MAX_THREADS = 5;
-
-static std::string webhook;
-static std::atomic_int threadCount;
-static json games;
+static RoutingTable routing;
 static std::set<std::string> disabledGames;
-static bool initialized;
+static std::once_flag initFlag;
+static DispatcherOptions dispatcherOptions;
+static RetryPolicy retryPolicy;
+static HttpOptions httpOptions;
+// aborts the requests still in progress when the exit timeout expires
+static CancelToken exitToken;
+// notifications given up at exit
+static std::atomic_size_t droppedAtExit { 0 };
+static std::unique_ptr<Outbox> outbox;
+static int outboxMaxAttempts = 20;
+static std::unique_ptr<Debouncer> debouncer;
+static TemplateSet templates;
+static WordFilter wordFilter;
+static std::map<std::string, TextEncoding> gameEncodings;
+static const std::string ENCODING_PREFIX = "encoding.";
+static std::unique_ptr<MessageIds> messageIds;
+// latest content of the status message of each route and game, waiting to be sent
+static std::mutex statusMutex;
+static std::map<std::pair<size_t, std::string>, Notif> pendingStatus;
+// maximum number of outbox messages sent by each run of the idle task
+static constexpr int OUTBOX_CLAIM_SIZE = 10;
 
-static void init()
-{
-	if (initialized)
-		return;
-	initialized = true;
-	std::ifstream ifs(GAMES_FILE);
-	if (ifs.fail())
-		throw DiscordException("Can't open " GAMES_FILE);
-	games = json::parse(ifs);
+// indexed by route
+static std::vector<std::unique_ptr<Sink>> sinks;
+// the routes of the dispatcher can't change once it has been created
+static std::atomic_bool dispatcherStarted { false };
+// as many notifications as a Discord message can hold
+static constexpr int MAX_BATCH_SIZE = 10;
 
+static void load()
+{
+	// exit within 5 seconds by default, whether Discord is configured or not
+	dispatcherOptions.drainTimeout = std::chrono::milliseconds(5000);
+	dispatcherOptions.cancelToken = &exitToken;
 	std::ifstream ifs2(CONF_FILE);
 	if (ifs2.fail()) {
 		fprintf(stderr, "Can't open " CONF_FILE ". Discord integration disabled.\n");
+		// discordForceWebhook() can still enable it
+		messageIds = std::make_unique<MessageIds>(":memory:");
 		return;
 	}
 	Config config = loadConfig(ifs2);
-	if (config.count("webhook") != 0)
-		webhook = config["webhook"][0];
+	routing.load(config);
 	const auto& disabled = config["disabled-games"];
 	disabledGames = { disabled.begin(), disabled.end() };
+	if (config.count("worker-threads") != 0)
+	{
+		int v = atoi(config["worker-threads"][0].c_str());
+		if (v > 0)
+			dispatcherOptions.threads = v;
+	}
+	if (config.count("queue-size") != 0)
+	{
+		int v = atoi(config["queue-size"][0].c_str());
+		if (v > 0)
+			dispatcherOptions.queueSize = v;
+	}
+	if (config.count("overflow-policy") != 0)
+		dispatcherOptions.overflow = parseOverflowPolicy(config["overflow-policy"][0]);
+	if (config.count("batch-size") != 0)
+	{
+		int v = atoi(config["batch-size"][0].c_str());
+		dispatcherOptions.batchSize = std::clamp(v, 1, MAX_BATCH_SIZE);
+	}
+	if (config.count("batch-window") != 0)
+		dispatcherOptions.batchWindow = std::chrono::milliseconds(std::max(0, atoi(config["batch-window"][0].c_str())));
+	httpOptions.load(config);
+	httpOptions.cancelToken = &exitToken;
+	if (config.count("exit-timeout") != 0)
+		dispatcherOptions.drainTimeout = std::chrono::milliseconds(std::max(0, atoi(config["exit-timeout"][0].c_str())));
+	retryPolicy.load(config);
+	if (config.count("outbox-max-attempts") != 0)
+		outboxMaxAttempts = std::max(1, atoi(config["outbox-max-attempts"][0].c_str()));
+	if (config.count("dedup-window") != 0)
+	{
+		int window = atoi(config["dedup-window"][0].c_str());
+		Debouncer::Mode mode = Debouncer::Mode::Fold;
+		if (config.count("dedup-mode") != 0)
+			mode = Debouncer::parseMode(config["dedup-mode"][0]);
+		if (window > 0)
+			debouncer = std::make_unique<Debouncer>(std::chrono::seconds(window), mode);
+	}
+	std::string outboxPath = OUTBOX_FILE;
+	if (config.count("outbox") != 0)
+		// an empty value disables the outbox
+		outboxPath = config["outbox"].empty() ? "" : config["outbox"][0];
+	if (!outboxPath.empty())
+	{
+		try {
+			outbox = std::make_unique<Outbox>(outboxPath);
+		} catch (const std::exception& e) {
+			fprintf(stderr, "Discord outbox disabled: %s\n", e.what());
+		}
+	}
+	for (const auto& [key, values] : config)
+		if (key.substr(0, ENCODING_PREFIX.length()) == ENCODING_PREFIX && !values.empty())
+			gameEncodings[key.substr(ENCODING_PREFIX.length())] = parseEncoding(values[0]);
+	if (config.count("word-filter") != 0 && !config["word-filter"].empty())
+	{
+		std::ifstream words(config["word-filter"][0]);
+		if (words.fail())
+			fprintf(stderr, "Can't open word list %s\n", config["word-filter"][0].c_str());
+		else
+			wordFilter = WordFilter::load(words);
+	}
+	std::string templatesPath = TEMPLATES_FILE;
+	if (config.count("templates") != 0 && !config["templates"].empty())
+		templatesPath = config["templates"][0];
+	std::ifstream templatesFile(templatesPath);
+	if (!templatesFile.fail())
+		templates.load(templatesFile);
+	else if (config.count("templates") != 0)
+		fprintf(stderr, "Can't open templates file %s\n", templatesPath.c_str());
+	std::string messagesPath = MESSAGES_FILE;
+	if (config.count("status-messages") != 0)
+		// an empty value keeps the message ids in memory only
+		messagesPath = config["status-messages"].empty() ? ":memory:" : config["status-messages"][0];
+	try {
+		messageIds = std::make_unique<MessageIds>(messagesPath);
+	} catch (const std::exception& e) {
+		fprintf(stderr, "Discord status message ids won't be persisted: %s\n", e.what());
+		messageIds = std::make_unique<MessageIds>(":memory:");
+	}
 }
 
-static void postWebhook(std::string body)
+static void init() {
+	std::call_once(initFlag, load);
+}
+
+// Appends a path and a query parameter to a webhook url, which may already have a query string
+static std::string webhookUrl(const std::string& url, const std::string& path, const std::string& param)
+{
+	size_t query = url.find('?');
+	std::string ret = url.substr(0, query) + path;
+	if (query != std::string::npos)
+	{
+		ret += url.substr(query);
+		if (!param.empty())
+			ret += '&' + param;
+	}
+	else if (!param.empty()) {
+		ret += '?' + param;
+	}
+	return ret;
+}
+
+static Dispatcher& getDispatcher();
+
+static void outboxDelivered(int64_t id)
 {
 	try {
-		Http().post(webhook, body, "application/json");
+		outbox->remove(id);
 	} catch (const std::exception& e) {
-		fprintf(stderr, "Discord: %s\n", e.what());
-	} catch (...) {
-		fprintf(stderr, "Discord: Unknown error\n");
+		fprintf(stderr, "Discord outbox: %s\n", e.what());
 	}
-	threadCount.fetch_sub(1);
 }
 
-void discordNotif(const std::string& gameId, const Notif& notif)
+static void outboxFailed(int64_t id, int attempts, bool retryable)
 {
-	init();
-	if (webhook.empty() || disabledGames.count(gameId) != 0)
+	try {
+		if (!retryable || attempts >= outboxMaxAttempts) {
+			fprintf(stderr, "Discord: message dropped after %d attempt(s)\n", attempts);
+			outbox->remove(id);
+			return;
+		}
+		int64_t delay = Outbox::backoff(attempts);
+		outbox->reschedule(id, attempts, time(nullptr) + delay);
+		getDispatcher().scheduleIdleTask(Dispatcher::clock::now() + std::chrono::seconds(delay));
+	} catch (const std::exception& e) {
+		fprintf(stderr, "Discord outbox: %s\n", e.what());
+	}
+}
+
+// How long outbox messages are leased to the worker sending them.
+// Must be longer than the worst-case time to send them so that they aren't sent twice
+// if the lease expires, by this process or another one sharing the outbox.
+static int64_t outboxLease(size_t messageCount)
+{
+	using namespace std::chrono;
+	// no request timeout: leave the messages of this process alone for one day
+	if (httpOptions.timeout.count() == 0)
+		return 24 * 60 * 60;
+	// 429 responses are retried in the worker, after waiting for the rate limit
+	seconds perMessage = duration_cast<seconds>(httpOptions.timeout + retryPolicy.maxDelay) * (retryPolicy.maxRetries + 1);
+	return (perMessage.count() + 60) * messageCount;
+}
+
+// Webhooks whose outbox messages are handled by this process
+static std::vector<std::string> outboxWebhooks()
+{
+	Dispatcher& dispatcher = getDispatcher();
+	std::vector<std::string> urls;
+	for (size_t i = 0; i < dispatcher.routeCount(); i++)
+		if (sinks[i]->persistent())
+			urls.push_back(dispatcher.getRoute(i).url);
+	return urls;
+}
+
+// Posts the outbox messages that are due
+static Dispatcher::clock::time_point retryOutbox(Dispatcher::clock::time_point now)
+{
+	if (outbox == nullptr)
+		return Dispatcher::clock::time_point::max();
+	Dispatcher& dispatcher = getDispatcher();
+	Dispatcher::clock::time_point next = Dispatcher::clock::time_point::max();
+	for (size_t i = 0; i < dispatcher.routeCount(); i++)
+	{
+		if (!sinks[i]->persistent())
+			continue;
+		Dispatcher::Route& route = dispatcher.getRoute(i);
+		Dispatcher::RouteClaim claim(dispatcher, route);
+		if (!claim) {
+			// a worker is delivering to it
+			next = now + std::chrono::seconds(1);
+			continue;
+		}
+		for (const Outbox::Entry& entry : outbox->claim({ route.url }, time(nullptr), outboxLease(OUTBOX_CLAIM_SIZE), OUTBOX_CLAIM_SIZE))
+		{
+			try {
+				sinks[i]->send(route, entry.payload);
+				outboxDelivered(entry.id);
+			} catch (const std::exception& e) {
+				fprintf(stderr, "Discord: %s\n", e.what());
+				outboxFailed(entry.id, entry.attempts + 1, isRetryable(e));
+			}
+		}
+	}
+	int64_t nextAttempt = outbox->nextAttempt(outboxWebhooks());
+	if (nextAttempt >= 0)
+		next = std::min(next, now + std::chrono::seconds(std::max<int64_t>(nextAttempt - time(nullptr), 0)));
+	return next;
+}
+
+// Serializes a batch and sends it to the sink of the route.
+// Payloads are kept in the outbox until delivered.
+static void deliver(Dispatcher::Route& route, std::vector<PendingNotif>& batch)
+{
+	Sink& sink = *sinks[route.index];
+	if (exitToken.isCancelled() && (outbox == nullptr || !sink.persistent()))
+	{
+		// the exit timeout has expired and nothing would keep them
+		droppedAtExit += batch.size();
 		return;
-	if (threadCount.fetch_add(1) >= MAX_THREADS) {
-		threadCount.fetch_sub(1);
-		throw DiscordException("Discord max thread count reached");
 	}
-	std::string gameName;
-	std::string gamePic;
-	try {
-		json g = games.at(gameId).get<json>();
-		gameName = g.at("name").get<std::string>();
-		gamePic = g.at("thumbnail").get<std::string>();
-	} catch (const json::exception& e) {
-		gameName = gameId;
-		gamePic = "https://dcnet.flyca.st/gamepic/unknown.jpg";
+	thread_local std::vector<std::string> payloads;
+	sink.serialize(batch, payloads);
+
+	std::vector<int64_t> ids;
+	if (outbox != nullptr && sink.persistent())
+	{
+		try {
+			ids = outbox->store(route.url, payloads, time(nullptr) + outboxLease(payloads.size()));
+		} catch (const std::exception& e) {
+			fprintf(stderr, "Discord outbox: %s\n", e.what());
+		}
 	}
+	for (size_t j = 0; j < payloads.size(); j++)
+	{
+		try {
+			sink.send(route, payloads[j]);
+			if (j < ids.size())
+				outboxDelivered(ids[j]);
+		} catch (const std::exception& e) {
+			fprintf(stderr, "Discord: %s\n", e.what());
+			if (j < ids.size())
+				outboxFailed(ids[j], 1, isRetryable(e));
+		}
+	}
+}
 
-	json embeds;
-	embeds.push_back({
-		{ "author",
+// Summaries of folded repeats waiting for their route, indexed by route. Only used by the idle task.
+static std::vector<std::vector<PendingNotif>> repeatBatches;
+
+// Posts the summaries of folded repeats
+static Dispatcher::clock::time_point flushRepeats(Dispatcher::clock::time_point now)
+{
+	if (debouncer == nullptr)
+		return Dispatcher::clock::time_point::max();
+	Dispatcher& dispatcher = getDispatcher();
+	// group them by route to batch them
+	repeatBatches.resize(dispatcher.routeCount());
+	for (Debouncer::Summary& summary : debouncer->expired(now))
+	{
+		int route = routing.route(summary.gameId);
+		if (route != RoutingTable::NoRoute)
+			repeatBatches[route].push_back(PendingNotif{ std::move(summary.gameId), std::move(summary.notif) });
+	}
+	Dispatcher::clock::time_point next = debouncer->nextExpiry();
+	std::vector<PendingNotif> batch;
+	for (size_t route = 0; route < repeatBatches.size(); route++)
+	{
+		if (repeatBatches[route].empty())
+			continue;
+		Dispatcher::RouteClaim claim(dispatcher, dispatcher.getRoute(route));
+		if (!claim) {
+			// a worker is delivering to it
+			next = std::min(next, now + std::chrono::seconds(1));
+			continue;
+		}
+		batch.clear();
+		batch.swap(repeatBatches[route]);
+		deliver(dispatcher.getRoute(route), batch);
+	}
+	return next;
+}
+
+// Edits the status message of a game, or creates it if it doesn't exist yet.
+// Failed updates are retried later by updateStatusMessages() rather than by sleeping.
+static void updateStatusMessage(Dispatcher::Route& route, const std::string& gameId, const std::string& payload)
+{
+	RetryPolicy policy = retryPolicy;
+	policy.retryErrors = false;
+	std::string messageId = messageIds->get(route.url, gameId);
+	if (!messageId.empty())
+	{
+		try {
+			sendRateLimited(route, webhookUrl(route.url, "/messages/" + messageId, ""), payload, policy, httpOptions, true);
+			return;
+		} catch (const HttpError& e) {
+			if (e.code != 404)
+				throw;
+			// the message has been deleted
+			messageIds->remove(route.url, gameId);
+		}
+	}
+	thread_local std::string response;
+	sendRateLimited(route, webhookUrl(route.url, "", "wait=true"), payload, policy, httpOptions, false, &response);
+	nlohmann::json json = nlohmann::json::parse(response, nullptr, false);
+	if (!json.is_object() || !json["id"].is_string()) {
+		fprintf(stderr, "Discord: no message id in webhook response\n");
+		return;
+	}
+	messageIds->set(route.url, gameId, json["id"].get<std::string>());
+}
+
+// Sends the pending status message updates
+static Dispatcher::clock::time_point updateStatusMessages(Dispatcher::clock::time_point now)
+{
+	std::map<std::pair<size_t, std::string>, Notif> updates;
+	{
+		std::lock_guard<std::mutex> _(statusMutex);
+		updates.swap(pendingStatus);
+	}
+	Dispatcher::clock::time_point next = Dispatcher::clock::time_point::max();
+	std::string payload;
+	Dispatcher& dispatcher = getDispatcher();
+	for (auto& [key, notif] : updates)
+	{
+		Dispatcher::Route& route = dispatcher.getRoute(key.first);
+		Dispatcher::RouteClaim claim(dispatcher, route);
+		if (!claim)
+		{
+			// a worker is delivering to it. Unless a more recent update is pending.
+			std::lock_guard<std::mutex> _(statusMutex);
+			pendingStatus.emplace(key, std::move(notif));
+			next = std::min(next, now + std::chrono::seconds(1));
+			continue;
+		}
+		const std::string& gameId = key.second;
+		JsonWriter writer(payload);
+		writer.beginObject()
+			.field("content", notif.content)
+			.key("embeds").beginArray();
+		DiscordSink::writeEmbed(writer, PendingNotif{ gameId, notif });
+		writer.endArray().endObject();
+		try {
+			updateStatusMessage(route, gameId, payload);
+		} catch (const std::exception& e) {
+			fprintf(stderr, "Discord: %s\n", e.what());
+			if (isRetryable(e))
 			{
-				{ "name", gameName },
-				{ "icon_url", gamePic }
-			},
-		},
-		{ "title", notif.embed.title },
-		{ "description", notif.embed.text },
-		{ "color", 9118205 },
-	});
-	json jnotif = {
-		{ "content", notif.content },
-		{ "embeds", embeds },
-	};
-
-	std::thread thread(postWebhook, jnotif.dump(4, ' ', false, json::error_handler_t::replace));
-	thread.detach();
+				// unless a more recent update is pending
+				std::lock_guard<std::mutex> _(statusMutex);
+				pendingStatus.emplace(key, std::move(notif));
+				next = std::min(next, now + std::chrono::seconds(10));
+			}
+		}
+	}
+	return next;
 }
 
-void discordSetWebhook(std::string_view) {
+static Dispatcher::clock::time_point idleTask(Dispatcher::clock::time_point now)
+{
+	Dispatcher::clock::time_point next = flushRepeats(now);
+	next = std::min(next, updateStatusMessages(now));
+	return std::min(next, retryOutbox(now));
+}
+
+static bool createSinks()
+{
+	// failed messages are retried later by the outbox rather than by sleeping workers
+	RetryPolicy sinkPolicy = retryPolicy;
+	sinkPolicy.retryErrors = outbox == nullptr;
+	for (const std::string& url : routing.webhooks())
+		sinks.push_back(createSink(url, sinkPolicy, httpOptions));
+	return true;
+}
+
+static Dispatcher& getDispatcher()
+{
+	dispatcherStarted = true;
+	// the workers look games up: the catalogs must be destroyed after the dispatcher
+	overrideCatalog();
+	remoteCatalog();
+	static bool sinksCreated = createSinks();
+	// destroyed after the dispatcher
+	static struct ExitReport {
+		~ExitReport() {
+			if (droppedAtExit > 0)
+				fprintf(stderr, "Discord: %zu notification(s) dropped at exit\n", droppedAtExit.load());
+		}
+	} exitReport;
+	static Dispatcher dispatcher(dispatcherOptions, routing.webhooks(), deliver, idleTask);
+	(void)sinksCreated;
+	return dispatcher;
+}
+
+// Queues a notification whose text is UTF-8
+static void postNotif(const std::string& gameId, Notif&& notif)
+{
+	if (disabledGames.count(gameId) != 0)
+		return;
+	int route = routing.route(gameId);
+	if (route == RoutingTable::NoRoute)
+		return;
+	if (debouncer != nullptr && !debouncer->admit(gameId, notif))
+	{
+		getDispatcher().scheduleIdleTask(debouncer->nextExpiry());
+		return;
+	}
+	if (!getDispatcher().enqueue(route, PendingNotif{ gameId, std::move(notif) }))
+		throw DiscordException("Discord queue full");
+}
+
+static TextEncoding gameEncoding(const std::string& gameId)
+{
+	auto it = gameEncodings.find(gameId);
+	return it == gameEncodings.end() ? TextEncoding::Utf8 : it->second;
+}
+
+// Masks the banned words of a raw string in place. It must be escaped afterwards.
+static void filterText(std::string& str)
+{
+	thread_local std::string filtered;
+	if (wordFilter.mask(str, filtered))
+		str.swap(filtered);
+}
+
+// Masks the banned words of a markdown string in place, escaping the mask
+static void filterMarkdown(std::string& str)
+{
+	thread_local std::string filtered;
+	if (wordFilter.maskEscaped(str, filtered))
+		str.swap(filtered);
+}
+
+// Converts the text of a notification to UTF-8 if the game uses another encoding,
+// and masks banned words
+static Notif convertNotif(const std::string& gameId, const Notif& notif)
+{
+	TextEncoding encoding = gameEncoding(gameId);
+	Notif converted;
+	if (encoding == TextEncoding::Utf8)
+	{
+		converted = notif;
+	}
+	else
+	{
+		converted.priority = notif.priority;
+		appendUtf8(converted.content, notif.content, encoding);
+		appendUtf8(converted.embed.title, notif.embed.title, encoding);
+		appendUtf8(converted.embed.text, notif.embed.text, encoding);
+	}
+	// the caller has escaped the text coming from players
+	filterMarkdown(converted.content);
+	filterMarkdown(converted.embed.title);
+	filterMarkdown(converted.embed.text);
+	return converted;
+}
+
+void discordNotif(const std::string& gameId, const Notif& notif)
+{
 	init();
+	postNotif(gameId, convertNotif(gameId, notif));
 }
 
-// for tests
-void discordForceWebhook(std::string_view url) {
-	webhook = url;
+static void templateNotif(const std::string& gameId, std::string_view templateName, const TemplateArg *args, size_t count,
+		NotifPriority priority)
+{
+	init();
+	TextEncoding encoding = gameEncoding(gameId);
+	std::vector<std::string> values;
+	std::vector<TemplateArg> convertedArgs;
+	if (encoding != TextEncoding::Utf8 || !wordFilter.empty())
+	{
+		// only the arguments come from the game, templates are UTF-8.
+		// Banned words are masked before the arguments are escaped.
+		values.resize(count);
+		convertedArgs.assign(args, args + count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (args[i].isNumber)
+				continue;
+			values[i] = encoding == TextEncoding::Utf8 ? std::string(args[i].value) : toUtf8(args[i].value, encoding);
+			filterText(values[i]);
+			convertedArgs[i].value = values[i];
+		}
+		args = convertedArgs.data();
+	}
+	Notif notif;
+	notif.priority = priority;
+	if (!templates.render(gameId, templateName, args, count, notif))
+		throw DiscordException("Unknown template: " + std::string(templateName));
+	postNotif(gameId, std::move(notif));
 }
 
-std::string discordEscape(std::string_view str)
+void discordTemplateNotif(const std::string& gameId, std::string_view templateName,
+		std::initializer_list<TemplateArg> args, NotifPriority priority)
 {
-	std::string ret;
-	for (char c : str)
+	templateNotif(gameId, templateName, args.begin(), args.size(), priority);
+}
+
+void discordStatusMessage(const std::string& gameId, const Notif& notif)
+{
+	init();
+	if (disabledGames.count(gameId) != 0)
+		return;
+	int route = routing.route(gameId);
+	if (route == RoutingTable::NoRoute)
+		return;
+	Notif converted = convertNotif(gameId, notif);
+	Dispatcher& dispatcher = getDispatcher();
+	if (dynamic_cast<DiscordSink *>(sinks[route].get()) == nullptr) {
+		// other sinks can't edit messages
+		postNotif(gameId, std::move(converted));
+		return;
+	}
 	{
-		if (c == '*' || c == '_' || c == '`' || c == '~' || c == '<'
-				|| c == '>' || c == ':' || c == '[' || c == '\\')
-			ret += '\\';
-		ret += c;
+		std::lock_guard<std::mutex> _(statusMutex);
+		pendingStatus[{ (size_t)route, gameId }] = std::move(converted);
 	}
-	return ret;
+	dispatcher.scheduleIdleTask(Dispatcher::clock::now());
+}
+
+void discordSetWebhook(std::string_view) {
+	init();
+}
+
+void discordInit()
+{
+	init();
+	// start the worker threads
+	getDispatcher();
+}
+
+// for tests, before the first notification: routes are fixed once the dispatcher has started
+void discordForceWebhook(std::string_view url)
+{
+	init();
+	if (dispatcherStarted)
+		throw DiscordException("Webhooks can't be changed once notifications have been sent");
+	routing.setDefaultWebhook(std::string(url));
 }
 
 //
@@ -156,8 +635,15 @@ void discordSetWebhook(const char *) {
 }
 
 int discordNotif(const char *gameId, const char *content, const char *embedTitle, const char *embedText)
+{
+	return discordNotifPriority(gameId, content, embedTitle, embedText, DISCORD_PRIORITY_NORMAL);
+}
+
+int discordNotifPriority(const char *gameId, const char *content, const char *embedTitle, const char *embedText,
+		DiscordPriority priority)
 {
 	Notif notif;
+	notif.priority = (NotifPriority)std::clamp<int>(priority, DISCORD_PRIORITY_LOW, DISCORD_PRIORITY_HIGH);
 	notif.content = content;
 	notif.embed.title = embedTitle;
 	notif.embed.text = embedText;
@@ -170,12 +656,34 @@ int discordNotif(const char *gameId, const char *content, const char *embedTitle
 	}
 }
 
-char *discordEscape(const char *s)
+int discordStatusMessage(const char *gameId, const char *content, const char *embedTitle, const char *embedText)
 {
-	std::string ret = discordEscape(std::string_view{ s });
-	char *r = (char *)malloc(ret.length() + 1);
-	strcpy(r, ret.c_str());
-	return r;
+	Notif notif;
+	notif.content = content;
+	notif.embed.title = embedTitle;
+	notif.embed.text = embedText;
+	try {
+		discordStatusMessage(gameId, notif);
+		return 0;
+	} catch (const std::exception& e) {
+		fprintf(stderr, "discord error: %s\n", e.what());
+		return -1;
+	}
 }
 
+int discordTemplateNotif(const char *gameId, const char *templateName,
+		const char * const *argNames, const char * const *argValues, int count)
+{
+	try {
+		std::vector<TemplateArg> args;
+		args.reserve(std::max(count, 0));
+		for (int i = 0; i < count; i++)
+			args.emplace_back(argNames[i], argValues[i]);
+		templateNotif(gameId, templateName, args.data(), args.size(), NotifPriority::Normal);
+		return 0;
+	} catch (const std::exception& e) {
+		fprintf(stderr, "discord error: %s\n", e.what());
+		return -1;
+	}
+}
 }
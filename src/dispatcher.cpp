@@ -0,0 +1,329 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "dispatcher.h"
+#include <algorithm>
+#include <stdio.h>
+
+OverflowPolicy parseOverflowPolicy(std::string_view s)
+{
+	if (s == "block")
+		return OverflowPolicy::Block;
+	if (s == "drop-newest")
+		return OverflowPolicy::DropNewest;
+	if (s != "drop-oldest")
+		fprintf(stderr, "Unknown overflow policy: %.*s\n", (int)s.length(), s.data());
+	return OverflowPolicy::DropOldest;
+}
+
+Dispatcher::Dispatcher(const DispatcherOptions& options, const std::vector<std::string>& urls, Handler handler,
+		IdleTask idleTask)
+	: options(options), handler(handler), idleTask(idleTask)
+{
+	for (const auto& url : urls)
+		routes.push_back(std::make_unique<Route>(routes.size(), url, options.queueSize));
+	unsigned threads = std::max(options.threads, 1u);
+	runningWorkers = threads;
+	for (unsigned i = 0; i < threads; i++)
+		workers.emplace_back(&Dispatcher::run, this);
+}
+
+Dispatcher::~Dispatcher()
+{
+	bool expired;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+		generation.fetch_add(1);
+		workAvailable.notify_all();
+		expired = options.drainTimeout.count() != 0
+				&& !workerExited.wait_for(lock, options.drainTimeout, [this]() { return runningWorkers == 0; });
+		if (expired)
+		{
+			drainExpired = true;
+			generation.fetch_add(1);
+			workAvailable.notify_all();
+		}
+	}
+	if (expired)
+	{
+		fprintf(stderr, "Discord: exit timeout expired, cancelling pending requests\n");
+		if (options.cancelToken != nullptr)
+			options.cancelToken->cancel();
+	}
+	for (auto& thread : workers)
+		thread.join();
+}
+
+bool Dispatcher::enqueue(size_t routeIdx, PendingNotif&& notif)
+{
+	Route& route = *routes.at(routeIdx);
+	size_t priority = (size_t)notif.notif.priority;
+	Route::Class& cls = route.classes[priority];
+	notif.time = clock::now();
+	cls.enqueued.fetch_add(1, std::memory_order_relaxed);
+	// reserve a slot
+	while (route.size.fetch_add(1) >= options.queueSize)
+	{
+		route.size.fetch_sub(1);
+		// make room by discarding a lower priority notification
+		if (shed(route, priority))
+			continue;
+		switch (options.overflow)
+		{
+		case OverflowPolicy::DropNewest:
+			if (route.size.load() < options.queueSize)
+				// a worker made room in the meantime
+				break;
+			cls.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+
+		case OverflowPolicy::DropOldest:
+			if (shed(route, priority + 1) || route.size.load() < options.queueSize)
+				break;
+			// only higher priority notifications are queued
+			cls.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+
+		case OverflowPolicy::Block:
+			{
+				// Workers signal when they pop, the timeout is only a safety net
+				std::unique_lock<std::mutex> lock(mutex);
+				blockedProducers.fetch_add(1);
+				notFull.wait_for(lock, std::chrono::milliseconds(10));
+				blockedProducers.fetch_sub(1);
+			}
+			break;
+		}
+	}
+	// the queue of each class can hold queueSize notifications, so this shouldn't fail
+	if (!cls.queue.tryPush(std::move(notif)))
+	{
+		// release the slot
+		route.size.fetch_sub(1);
+		if (blockedProducers.load() > 0)
+		{
+			std::lock_guard<std::mutex> _(mutex);
+			notFull.notify_one();
+		}
+		cls.dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	wakeWorker();
+	return true;
+}
+
+// Discards the oldest notification of the lowest priority class below maxPriority
+bool Dispatcher::shed(Route& route, size_t maxPriority)
+{
+	PendingNotif oldest;
+	for (size_t i = 0; i < maxPriority; i++)
+	{
+		if (route.classes[i].queue.tryPop(oldest))
+		{
+			route.size.fetch_sub(1);
+			route.classes[i].dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t Dispatcher::droppedCount(size_t route) const
+{
+	uint64_t count = 0;
+	for (const Route::Class& cls : routes.at(route)->classes)
+		count += cls.dropped.load(std::memory_order_relaxed);
+	return count;
+}
+
+Dispatcher::ClassStats Dispatcher::classStats(size_t route, NotifPriority priority) const
+{
+	const Route::Class& cls = routes.at(route)->classes[(size_t)priority];
+	return ClassStats {
+		cls.enqueued.load(std::memory_order_relaxed),
+		cls.sent.load(std::memory_order_relaxed),
+		cls.dropped.load(std::memory_order_relaxed)
+	};
+}
+
+void Dispatcher::wakeWorker()
+{
+	// Pairs with the increment of idleWorkers before a worker checks the generation
+	generation.fetch_add(1);
+	if (idleWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		workAvailable.notify_one();
+	}
+}
+
+Dispatcher::RouteClaim::RouteClaim(Dispatcher& dispatcher, Route& route)
+	: dispatcher(dispatcher), route(route),
+	  owned(!route.claimed.exchange(true, std::memory_order_acquire))
+{
+}
+
+Dispatcher::RouteClaim::~RouteClaim()
+{
+	if (!owned)
+		return;
+	route.claimed.store(false, std::memory_order_release);
+	// workers skipped the route while it was claimed
+	dispatcher.wakeWorker();
+}
+
+Dispatcher::Route *Dispatcher::findRoute(const std::string& url)
+{
+	for (auto& route : routes)
+		if (route->url == url)
+			return route.get();
+	return nullptr;
+}
+
+void Dispatcher::scheduleIdleTask(clock::time_point time)
+{
+	clock::rep t = time.time_since_epoch().count();
+	clock::rep cur = idleTaskTime.load();
+	while (t < cur && !idleTaskTime.compare_exchange_weak(cur, t))
+		;
+	wakeWorker();
+}
+
+// Runs the idle task if it's due and not already running.
+// Otherwise nextWake is updated with the time at which it will be due.
+bool Dispatcher::runIdleTask(clock::time_point now, clock::time_point& nextWake)
+{
+	if (!idleTask || stopping)
+		return false;
+	clock::time_point time { clock::duration(idleTaskTime.load()) };
+	if (time > now) {
+		nextWake = std::min(nextWake, time);
+		return false;
+	}
+	if (idleTaskRunning.exchange(true))
+		return false;
+	idleTaskTime = clock::time_point::max().time_since_epoch().count();
+	clock::time_point next;
+	try {
+		next = idleTask(now);
+	} catch (const std::exception& e) {
+		fprintf(stderr, "Discord: %s\n", e.what());
+		next = now + std::chrono::minutes(1);
+	}
+	idleTaskRunning = false;
+	// keep an earlier time set while the task was running
+	scheduleIdleTask(next);
+	return true;
+}
+
+bool Dispatcher::pop(Route& route, PendingNotif& notif)
+{
+	size_t i = PriorityCount;
+	while (!route.classes[i - 1].queue.tryPop(notif))
+		if (--i == 0)
+			return false;
+	route.size.fetch_sub(1);
+	if (blockedProducers.load() > 0)
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		notFull.notify_one();
+	}
+	return true;
+}
+
+// Moves queued notifications of a claimed route to its staging area and
+// returns true if a batch is ready to be sent.
+// Otherwise nextWake is updated with the time at which it will be.
+bool Dispatcher::inspect(Route& route, clock::time_point now, clock::time_point& nextWake)
+{
+	PendingNotif notif;
+	while (route.staged.size() < options.batchSize && pop(route, notif))
+		route.staged.push_back(std::move(notif));
+	if (route.staged.empty())
+		return false;
+
+	clock::time_point readyTime = route.staged.front().time + options.batchWindow;
+	if (route.staged.size() >= options.batchSize || stopping)
+		readyTime = now;
+	if (!drainExpired)
+		readyTime = std::max(readyTime, route.rateLimiter.readyTime(now));
+	if (readyTime <= now)
+		return true;
+	nextWake = std::min(nextWake, readyTime);
+	return false;
+}
+
+void Dispatcher::run()
+{
+	std::vector<PendingNotif> batch;
+	for (;;)
+	{
+		uint64_t gen = generation.load();
+		clock::time_point now = clock::now();
+		clock::time_point nextWake = clock::time_point::max();
+		Route *ready = nullptr;
+		size_t start = nextRoute.fetch_add(1);
+		for (size_t i = 0; i < routes.size() && ready == nullptr; i++)
+		{
+			Route& route = *routes[(start + i) % routes.size()];
+			if (route.claimed.exchange(true, std::memory_order_acquire))
+				continue;
+			if (inspect(route, now, nextWake))
+				ready = &route;
+			else
+				route.claimed.store(false, std::memory_order_release);
+		}
+		if (ready != nullptr)
+		{
+			if (nextWake != clock::time_point::max())
+				// let an idle worker take care of the other pending routes
+				wakeWorker();
+			batch.clear();
+			std::swap(batch, ready->staged);
+			for (const PendingNotif& notif : batch)
+				ready->classes[(size_t)notif.notif.priority].sent.fetch_add(1, std::memory_order_relaxed);
+			try {
+				handler(*ready, batch);
+			} catch (const std::exception& e) {
+				fprintf(stderr, "Discord: %s\n", e.what());
+			} catch (...) {
+				fprintf(stderr, "Discord: Unknown error\n");
+			}
+			ready->claimed.store(false, std::memory_order_release);
+			continue;
+		}
+		if (runIdleTask(now, nextWake))
+			continue;
+		std::unique_lock<std::mutex> lock(mutex);
+		if (stopping && nextWake == clock::time_point::max() && generation.load() == gen)
+			// nothing left to do
+			break;
+		idleWorkers.fetch_add(1);
+		auto pred = [&]() {
+			return generation.load() != gen;
+		};
+		if (nextWake == clock::time_point::max())
+			workAvailable.wait(lock, pred);
+		else
+			workAvailable.wait_until(lock, nextWake, pred);
+		idleWorkers.fetch_sub(1);
+	}
+	std::lock_guard<std::mutex> _(mutex);
+	runningWorkers--;
+	workerExited.notify_all();
+}
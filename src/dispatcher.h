@@ -0,0 +1,193 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "discord.hpp"
+#include "internal.h"
+#include "queue.h"
+#include "ratelimit.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct PendingNotif
+{
+	std::string gameId;
+	Notif notif;
+	std::chrono::steady_clock::time_point time;
+};
+
+// Lower priority notifications are always discarded first, whatever the policy
+enum class OverflowPolicy
+{
+	Block,			// wait until a worker frees a slot
+	DropOldest,		// discard the oldest queued notification
+	DropNewest,		// reject the new notification
+};
+
+OverflowPolicy parseOverflowPolicy(std::string_view s);
+
+struct DispatcherOptions
+{
+	unsigned threads = 2;
+	// Queue size of each route, all priorities included
+	size_t queueSize = 256;
+	OverflowPolicy overflow = OverflowPolicy::DropOldest;
+	// Maximum number of notifications handled together
+	size_t batchSize = 10;
+	// How long to wait for more notifications once the first one of a batch is received
+	std::chrono::milliseconds batchWindow { 2000 };
+	// How long the destructor waits for the routes to drain. Zero waits until they are.
+	// Past this delay, rate limits are ignored and cancelToken is cancelled so that the
+	// handler can give up on the remaining notifications.
+	std::chrono::milliseconds drainTimeout { 0 };
+	CancelToken *cancelToken = nullptr;
+};
+
+//
+// Pool of long-lived worker threads delivering notifications to a set of routes.
+// Each route has its own bounded queues and rate limiter, and is served by at most one worker
+// at a time so that a busy or rate-limited route can't hold up the others.
+// Notifications are handed to workers in batches, highest priority first.
+//
+class Dispatcher
+{
+public:
+	using clock = std::chrono::steady_clock;
+	static constexpr size_t PriorityCount = (size_t)NotifPriority::High + 1;
+
+	struct ClassStats
+	{
+		uint64_t enqueued;
+		uint64_t sent;
+		uint64_t dropped;
+	};
+
+	class Route
+	{
+	public:
+		Route(size_t index, const std::string& url, size_t queueSize)
+			: index(index), url(url), classes { Class(queueSize), Class(queueSize), Class(queueSize) } {}
+
+		const size_t index;
+		const std::string url;
+		RateLimiter rateLimiter;
+
+	private:
+		struct Class
+		{
+			Class(size_t queueSize) : queue(queueSize) {}
+
+			BoundedQueue<PendingNotif> queue;
+			std::atomic_uint64_t enqueued { 0 };
+			std::atomic_uint64_t sent { 0 };
+			std::atomic_uint64_t dropped { 0 };
+		};
+		Class classes[PriorityCount];
+		// number of queued notifications plus pending insertions
+		std::atomic_size_t size { 0 };
+		// notifications taken from the queues and waiting for the batch to be complete
+		std::vector<PendingNotif> staged;
+		std::atomic_bool claimed { false };
+
+		friend class Dispatcher;
+	};
+	// Keeps the workers away from a route, as a worker does while its handler runs,
+	// so that the idle task can deliver to the route without racing with them.
+	class RouteClaim
+	{
+	public:
+		RouteClaim(Dispatcher& dispatcher, Route& route);
+		RouteClaim(const RouteClaim&) = delete;
+		RouteClaim& operator=(const RouteClaim&) = delete;
+		~RouteClaim();
+
+		// false if the route is busy
+		explicit operator bool() const {
+			return owned;
+		}
+
+	private:
+		Dispatcher& dispatcher;
+		Route& route;
+		bool owned;
+	};
+	using Handler = std::function<void(Route&, std::vector<PendingNotif>&)>;
+	// Background task run by an otherwise idle worker, never concurrently.
+	// Returns the time at which it should run again.
+	using IdleTask = std::function<clock::time_point(clock::time_point now)>;
+
+	Dispatcher(const DispatcherOptions& options, const std::vector<std::string>& urls, Handler handler,
+			IdleTask idleTask = nullptr);
+	Dispatcher(const Dispatcher&) = delete;
+	Dispatcher& operator=(const Dispatcher&) = delete;
+	// Stops the workers once all routes have been drained, or the drain timeout has expired
+	~Dispatcher();
+
+	// Returns false if the notification has been rejected because the route queue is full
+	bool enqueue(size_t route, PendingNotif&& notif);
+
+	size_t routeCount() const {
+		return routes.size();
+	}
+	uint64_t droppedCount(size_t route) const;
+	ClassStats classStats(size_t route, NotifPriority priority) const;
+	Route& getRoute(size_t route) {
+		return *routes.at(route);
+	}
+	Route *findRoute(const std::string& url);
+
+	// Runs the idle task no later than the given time
+	void scheduleIdleTask(clock::time_point time);
+
+private:
+	void run();
+	bool inspect(Route& route, clock::time_point now, clock::time_point& nextWake);
+	bool pop(Route& route, PendingNotif& notif);
+	bool shed(Route& route, size_t maxPriority);
+	bool runIdleTask(clock::time_point now, clock::time_point& nextWake);
+	void wakeWorker();
+
+	const DispatcherOptions options;
+	std::vector<std::unique_ptr<Route>> routes;
+	Handler handler;
+	IdleTask idleTask;
+	std::atomic<clock::rep> idleTaskTime { 0 };
+	std::atomic_bool idleTaskRunning { false };
+	std::vector<std::thread> workers;
+	std::atomic_size_t nextRoute { 0 };
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable notFull;
+	// signalled when a worker exits
+	std::condition_variable workerExited;
+	unsigned runningWorkers = 0;
+	// incremented whenever something may have become ready
+	std::atomic_uint64_t generation { 0 };
+	std::atomic_int idleWorkers { 0 };
+	std::atomic_int blockedProducers { 0 };
+	std::atomic_bool stopping { false };
+	std::atomic_bool drainExpired { false };
+};
@@ -0,0 +1,175 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "encoding.h"
+#include "encoding.hpp"
+#include "sjis_table.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdio.h>
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define HAVE_SSE2
+#endif
+
+//
+// Table-driven conversion of Shift-JIS and Latin-1 to UTF-8.
+// ASCII runs are found 16 bytes at a time with SSE2 and copied as is.
+//
+
+TextEncoding parseEncoding(std::string_view name)
+{
+	if (name == "shift-jis" || name == "sjis" || name == "cp932")
+		return TextEncoding::ShiftJis;
+	if (name == "latin1" || name == "iso-8859-1")
+		return TextEncoding::Latin1;
+	if (name != "utf-8" && name != "utf8")
+		fprintf(stderr, "Unknown encoding: %.*s\n", (int)name.length(), name.data());
+	return TextEncoding::Utf8;
+}
+
+// Returns the index of the first non-ASCII byte in [pos, len), or len if none
+static size_t asciiRun(const uint8_t *s, size_t pos, size_t len)
+{
+#ifdef HAVE_SSE2
+	for (; pos + 16 <= len; pos += 16)
+	{
+		unsigned mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + pos)));
+		if (mask != 0)
+			return pos + __builtin_ctz(mask);
+	}
+#endif
+	while (pos < len && s[pos] < 0x80)
+		pos++;
+	return pos;
+}
+
+// Decodes the non-ASCII character at pos and advances pos
+static uint32_t decode(TextEncoding encoding, const uint8_t *s, size_t& pos, size_t len)
+{
+	uint8_t c = s[pos++];
+	if (encoding == TextEncoding::Latin1)
+		return c;
+	// Shift-JIS
+	if (c >= 0xa1 && c <= 0xdf)
+		// half-width katakana
+		return 0xff61 + c - 0xa1;
+	unsigned lead = sjis::leadIndex[c];
+	if (lead == 0 || pos == len)
+		return 0xfffd;
+	unsigned trail = s[pos];
+	if (trail < sjis::TRAIL_FIRST || trail >= sjis::TRAIL_FIRST + sjis::TRAIL_COUNT || trail == 0x7f)
+		// leave an invalid trail byte alone, it might be ASCII
+		return 0xfffd;
+	pos++;
+	uint16_t code = sjis::table[lead - 1][trail - sjis::TRAIL_FIRST];
+	return code == 0 ? 0xfffd : code;
+}
+
+static size_t encodeUtf8(uint32_t code, char *out)
+{
+	if (code < 0x80) {
+		out[0] = (char)code;
+		return 1;
+	}
+	if (code < 0x800) {
+		out[0] = (char)(0xc0 | (code >> 6));
+		out[1] = (char)(0x80 | (code & 0x3f));
+		return 2;
+	}
+	out[0] = (char)(0xe0 | (code >> 12));
+	out[1] = (char)(0x80 | ((code >> 6) & 0x3f));
+	out[2] = (char)(0x80 | (code & 0x3f));
+	return 3;
+}
+
+// Writes at most cap bytes of the converted string to out and returns its full length.
+// A UTF-8 sequence is never truncated, and nothing is written after the first truncation.
+// The number of bytes actually written is returned in written.
+static size_t transcode(TextEncoding encoding, const char *str, size_t len, char *out, size_t cap, size_t& written)
+{
+	const uint8_t *s = (const uint8_t *)str;
+	size_t o = 0;
+	size_t pos = 0;
+	while (pos < len)
+	{
+		size_t next = encoding == TextEncoding::Utf8 ? len : asciiRun(s, pos, len);
+		size_t run = next - pos;
+		if (o < cap)
+		{
+			size_t n = std::min(run, cap - o);
+			memcpy(out + o, s + pos, n);
+			if (n < run)
+				cap = o + n;
+		}
+		o += run;
+		pos = next;
+		if (pos == len)
+			break;
+		uint32_t code = decode(encoding, s, pos, len);
+		if (o + 3 <= cap) {
+			o += encodeUtf8(code, out + o);
+			continue;
+		}
+		char utf8[3];
+		size_t n = encodeUtf8(code, utf8);
+		if (o + n <= cap)
+			memcpy(out + o, utf8, n);
+		else
+			cap = std::min(cap, o);
+		o += n;
+	}
+	written = std::min(o, cap);
+	return o;
+}
+
+void appendUtf8(std::string& out, std::string_view s, TextEncoding encoding)
+{
+	// at most 3 bytes per input byte
+	size_t offset = out.length();
+	size_t cap = encoding == TextEncoding::Utf8 ? s.length() : s.length() * 3;
+	out.resize(offset + cap);
+	size_t written;
+	transcode(encoding, s.data(), s.length(), out.data() + offset, cap, written);
+	out.resize(offset + written);
+}
+
+std::string toUtf8(std::string_view s, TextEncoding encoding)
+{
+	std::string out;
+	appendUtf8(out, s, encoding);
+	return out;
+}
+
+extern "C"
+{
+
+size_t transcodeToUtf8(DcEncoding encoding, const char *s, char *buf, size_t bufsize)
+{
+	TextEncoding enc = encoding == DC_ENCODING_SHIFT_JIS ? TextEncoding::ShiftJis
+			: encoding == DC_ENCODING_LATIN1 ? TextEncoding::Latin1 : TextEncoding::Utf8;
+	size_t len = strlen(s);
+	size_t written;
+	if (bufsize == 0)
+		return transcode(enc, s, len, nullptr, 0, written);
+	size_t outlen = transcode(enc, s, len, buf, bufsize - 1, written);
+	buf[written] = '\0';
+	return outlen;
+}
+
+}
@@ -0,0 +1,187 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "discord.h"
+#include "discord.hpp"
+#include "internal.h"
+#include <algorithm>
+#include <cstring>
+#include <stdlib.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
+//
+// Markdown escaping of Discord messages.
+// Special characters are searched 16 or 32 bytes at a time when SSE2 or AVX2 are available.
+//
+
+// Returns the index of the first special character in [pos, len), or len if none
+using ScanFn = size_t (*)(const char *s, size_t pos, size_t len);
+
+static constexpr char SPECIAL_CHARS[] = { '*', '_', '`', '~', '<', '>', ':', '[', '\\' };
+
+static bool isSpecial(char c)
+{
+	for (char sc : SPECIAL_CHARS)
+		if (c == sc)
+			return true;
+	return false;
+}
+
+static size_t scanScalar(const char *s, size_t pos, size_t len)
+{
+	while (pos < len && !isSpecial(s[pos]))
+		pos++;
+	return pos;
+}
+
+#ifdef HAVE_X86_SIMD
+static size_t scanSse2(const char *s, size_t pos, size_t len)
+{
+	for (; pos + 16 <= len; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + pos));
+		__m128i m = _mm_setzero_si128();
+		for (char sc : SPECIAL_CHARS)
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(sc)));
+		unsigned mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return pos + __builtin_ctz(mask);
+	}
+	return scanScalar(s, pos, len);
+}
+
+__attribute__((target("avx2")))
+static size_t scanAvx2(const char *s, size_t pos, size_t len)
+{
+	for (; pos + 32 <= len; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(s + pos));
+		__m256i m = _mm256_setzero_si256();
+		for (char sc : SPECIAL_CHARS)
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(sc)));
+		unsigned mask = _mm256_movemask_epi8(m);
+		if (mask != 0)
+			return pos + __builtin_ctz(mask);
+	}
+	return scanSse2(s, pos, len);
+}
+#endif
+
+static ScanFn selectScan()
+{
+#ifdef HAVE_X86_SIMD
+	// called by a static initializer, possibly before the cpu model is initialized
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return scanAvx2;
+	return scanSse2;
+#else
+	return scanScalar;
+#endif
+}
+
+static const ScanFn scanSpecial = selectScan();
+
+// Writes at most cap characters of the escaped string to out and returns its full length.
+// An escape sequence is never truncated, and nothing is written after the first truncation.
+// The number of characters actually written is returned in written.
+static size_t escape(const char *s, size_t len, char *out, size_t cap, size_t& written)
+{
+	size_t o = 0;
+	size_t pos = 0;
+	while (pos < len)
+	{
+		size_t next = scanSpecial(s, pos, len);
+		size_t run = next - pos;
+		if (o < cap)
+		{
+			size_t n = std::min(run, cap - o);
+			memcpy(out + o, s + pos, n);
+			if (n < run)
+				cap = o + n;
+		}
+		o += run;
+		pos = next;
+		if (pos == len)
+			break;
+		if (o + 2 <= cap) {
+			out[o] = '\\';
+			out[o + 1] = s[pos];
+		}
+		else {
+			cap = std::min(cap, o);
+		}
+		o += 2;
+		pos++;
+	}
+	written = std::min(o, cap);
+	return o;
+}
+
+std::string discordEscape(std::string_view str)
+{
+	std::string ret;
+	ret.resize(str.length() * 2);
+	size_t written;
+	escape(str.data(), str.length(), ret.data(), ret.length(), written);
+	ret.resize(written);
+	return ret;
+}
+
+void appendEscaped(std::string& out, std::string_view str)
+{
+	size_t offset = out.length();
+	out.resize(offset + str.length() * 2);
+	size_t written;
+	escape(str.data(), str.length(), out.data() + offset, str.length() * 2, written);
+	out.resize(offset + written);
+}
+
+extern "C"
+{
+
+char *discordEscape(const char *cstr)
+{
+	std::string_view str(cstr);
+	const char *s = str.data();
+	size_t len = str.length();
+	char *r = (char *)malloc(len * 2 + 1);
+	if (r == nullptr)
+		return nullptr;
+	size_t written;
+	escape(s, len, r, len * 2, written);
+	r[written] = '\0';
+	return r;
+}
+
+size_t discordEscapeInto(const char *cstr, char *buf, size_t bufsize)
+{
+	std::string_view str(cstr);
+	const char *s = str.data();
+	size_t len = str.length();
+	size_t written;
+	if (bufsize == 0)
+		return escape(s, len, nullptr, 0, written);
+	size_t outlen = escape(s, len, buf, bufsize - 1, written);
+	buf[written] = '\0';
+	return outlen;
+}
+
+}
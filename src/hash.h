@@ -0,0 +1,40 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+// FNV-1a hash. The offset basis can be changed to get a different hash function.
+constexpr uint64_t fnv1a(std::string_view s, uint64_t basis = FNV_OFFSET_BASIS)
+{
+	uint64_t h = basis;
+	for (char c : s) {
+		h ^= (uint8_t)c;
+		h *= 0x100000001b3ull;
+	}
+	return h;
+}
+
+// Table slot of a hash value. The high bits are folded in since the low bits of FNV-1a
+// only depend on the low bits of the input and basis.
+constexpr size_t hashSlot(uint64_t hash, size_t slotCount) {
+	return (hash ^ (hash >> 32)) & (slotCount - 1);
+}
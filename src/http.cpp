@@ -20,17 +20,251 @@
 #include <string>
 #include <string_view>
 #include <stdexcept>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <stdio.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 #include <curl/curl.h>
+#include <zlib.h>
 
-Http::Http()
+//
+// Pool of idle curl easy handles sharing a DNS cache, TLS session cache and connection cache
+//
+class HttpPool
 {
-	curl = curl_easy_init();
-	if (curl == nullptr)
-		throw std::runtime_error("can't create curl handle");
+public:
+	HttpPool()
+	{
+		curl_global_init(CURL_GLOBAL_DEFAULT);
+		share = curl_share_init();
+		curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock);
+		curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock);
+		curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+	}
+
+	CURL *acquire()
+	{
+		CURL *curl = nullptr;
+		{
+			std::lock_guard<std::mutex> _(mutex);
+			if (!idle.empty()) {
+				curl = idle.back();
+				idle.pop_back();
+			}
+		}
+		if (curl == nullptr)
+		{
+			curl = curl_easy_init();
+			if (curl == nullptr)
+				throw std::runtime_error("can't create curl handle");
+			std::lock_guard<std::mutex> _(mutex);
+			stats.handlesCreated++;
+		}
+		curl_easy_setopt(curl, CURLOPT_SHARE, share);
+		curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+		curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+		return curl;
+	}
+
+	void release(CURL *curl)
+	{
+		// options are reset but live connections and caches are kept
+		curl_easy_reset(curl);
+		std::lock_guard<std::mutex> _(mutex);
+		if (idle.size() < MAX_IDLE)
+			idle.push_back(curl);
+		else
+			curl_easy_cleanup(curl);
+	}
+
+	void compressed()
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		stats.compressedRequests++;
+	}
+
+	void failed(CURLcode res)
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		if (res == CURLE_OPERATION_TIMEDOUT)
+			stats.timeouts++;
+		else if (res == CURLE_ABORTED_BY_CALLBACK)
+			stats.cancelled++;
+	}
+
+	void completed(CURL *curl)
+	{
+		long connects = 0;
+		curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+		std::lock_guard<std::mutex> _(mutex);
+		stats.requests++;
+		if (connects == 0)
+			stats.reusedConnections++;
+	}
+
+	HttpStats getStats()
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		return stats;
+	}
+
+	// Never destroyed so that it outlives any static object using it
+	static HttpPool& instance()
+	{
+		static HttpPool *pool = new HttpPool();
+		return *pool;
+	}
+
+private:
+	static void lock(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+		((HttpPool *)userptr)->shareMutexes[data].lock();
+	}
+	static void unlock(CURL *, curl_lock_data data, void *userptr) {
+		((HttpPool *)userptr)->shareMutexes[data].unlock();
+	}
+
+	static constexpr size_t MAX_IDLE = 16;
+	CURLSH *share;
+	std::mutex shareMutexes[CURL_LOCK_DATA_LAST];
+	std::mutex mutex;
+	std::vector<CURL *> idle;
+	HttpStats stats;
+};
+
+HttpError::HttpError(long code)
+	: std::runtime_error(strprintf("HTTP error %ld", code)), code(code)
+{
+}
+
+CurlError::CurlError(int code)
+	: std::runtime_error(strprintf("curl error %d: %s", code, curl_easy_strerror((CURLcode)code))), code(code)
+{
+}
+
+bool CurlError::timedOut() const {
+	return code == CURLE_OPERATION_TIMEDOUT;
+}
+
+bool CurlError::cancelled() const {
+	return code == CURLE_ABORTED_BY_CALLBACK;
+}
+
+void HttpOptions::load(Config& config)
+{
+	if (config.count("connect-timeout") != 0 && !config["connect-timeout"].empty())
+		connectTimeout = std::chrono::milliseconds(std::max(0, atoi(config["connect-timeout"][0].c_str())));
+	if (config.count("request-timeout") != 0 && !config["request-timeout"].empty())
+		timeout = std::chrono::milliseconds(std::max(0, atoi(config["request-timeout"][0].c_str())));
+	if (config.count("compress-requests") != 0 && !config["compress-requests"].empty())
+	{
+		const std::string& v = config["compress-requests"][0];
+		if (v == "gzip")
+			gzip = true;
+		else if (v == "none")
+			gzip = false;
+		else
+			fprintf(stderr, "Unsupported request compression: %s\n", v.c_str());
+	}
+	if (config.count("compress-min-size") != 0 && !config["compress-min-size"].empty())
+		gzipMinSize = std::max(0, atoi(config["compress-min-size"][0].c_str()));
+}
+
+// Compresses data into a buffer owned by the calling thread, which is valid until the next call.
+// The deflate state is only reset between calls.
+static std::string_view gzipCompress(std::string_view data)
+{
+	struct Deflater
+	{
+		Deflater() {
+			ok = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+		}
+		~Deflater() {
+			if (ok)
+				deflateEnd(&stream);
+		}
+		z_stream stream {};
+		bool ok;
+	};
+	thread_local Deflater deflater;
+	thread_local std::string buffer;
+	if (!deflater.ok)
+		throw std::runtime_error("deflateInit2 failed");
+	z_stream& stream = deflater.stream;
+	deflateReset(&stream);
+	buffer.resize(deflateBound(&stream, data.size()));
+	stream.next_in = (Bytef *)data.data();
+	stream.avail_in = data.size();
+	stream.next_out = (Bytef *)&buffer[0];
+	stream.avail_out = buffer.size();
+	if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+		throw std::runtime_error("deflate failed");
+	buffer.resize(stream.total_out);
+	return buffer;
+}
+
+Http::Http(const HttpOptions& options)
+	: options(options)
+{
+	curl = HttpPool::instance().acquire();
 }
 
-void Http::post(const std::string& url, std::string_view body, std::string_view contentType)
+void Http::post(const std::string& url, std::string_view body, std::string_view contentType, const ResponseSink& response)
 {
+	if (send("POST", url, body, contentType, response) == 304)
+		throw HttpError(304);
+}
+
+void Http::patch(const std::string& url, std::string_view body, std::string_view contentType, const ResponseSink& response)
+{
+	if (send("PATCH", url, body, contentType, response) == 304)
+		throw HttpError(304);
+}
+
+bool Http::get(const std::string& url, const ResponseSink& response, HttpValidators *validators)
+{
+	std::vector<std::string> headers;
+	if (validators != nullptr)
+	{
+		if (!validators->etag.empty())
+			headers.push_back("If-None-Match: " + validators->etag);
+		if (!validators->lastModified.empty())
+			headers.push_back("If-Modified-Since: " + validators->lastModified);
+	}
+	long code = send("GET", url, {}, {}, response, headers);
+	if (code == 304)
+	{
+		if (validators == nullptr)
+			throw HttpError(code);
+		return false;
+	}
+	if (validators != nullptr)
+	{
+		validators->etag = responseHeader("etag");
+		validators->lastModified = responseHeader("last-modified");
+	}
+	return true;
+}
+
+long Http::send(const char *method, const std::string& url, std::string_view body, std::string_view contentType,
+		const ResponseSink& response, const std::vector<std::string>& extraHeaders)
+{
+	bool gzipped = false;
+	if (options.gzip && body.size() >= options.gzipMinSize && strcmp(method, "GET") != 0)
+	{
+		std::string_view compressed = gzipCompress(body);
+		if (compressed.size() < body.size())
+		{
+			body = compressed;
+			gzipped = true;
+			HttpPool::instance().compressed();
+		}
+	}
 	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 	curl_easy_setopt(curl, CURLOPT_USERAGENT, "DCNet-DiscordWebhook");
 	curl_slist *headers = nullptr;
@@ -38,22 +272,131 @@ void Http::post(const std::string& url, std::string_view body, std::string_view
 		std::string ctype = "Content-Type: " + std::string(contentType);
 		headers = curl_slist_append(headers, ctype.c_str());
 	}
+	for (const std::string& header : extraHeaders)
+		headers = curl_slist_append(headers, header.c_str());
+	if (gzipped)
+		headers = curl_slist_append(headers, "Content-Encoding: gzip");
 	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
-	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, body.size());
+	if (strcmp(method, "GET") == 0)
+	{
+		curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+	}
+	else
+	{
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, body.size());
+		if (strcmp(method, "POST") != 0)
+			curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+	}
+	// libcurl writes to stdout by default
+	if (response.str != nullptr)
+		response.str->clear();
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+
+	responseHeaders.clear();
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
+
+	curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)options.connectTimeout.count());
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)options.timeout.count());
+	// don't use signals for timeouts: we're multithreaded
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	if (!options.unixSocket.empty())
+		curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, options.unixSocket.c_str());
+	if (options.cancelToken != nullptr)
+	{
+		if (options.cancelToken->isCancelled()) {
+			curl_slist_free_all(headers);
+			HttpPool::instance().failed(CURLE_ABORTED_BY_CALLBACK);
+			throw CurlError(CURLE_ABORTED_BY_CALLBACK);
+		}
+		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progressCallback);
+		curl_easy_setopt(curl, CURLOPT_XFERINFODATA, options.cancelToken);
+		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+	}
 
 	CURLcode res = curl_easy_perform(curl);
 	curl_slist_free_all(headers);
-	if (res != CURLE_OK)
-		throw std::runtime_error(strprintf("curl error: %d", res));
+	if (res != CURLE_OK) {
+		HttpPool::instance().failed(res);
+		throw CurlError(res);
+	}
+	HttpPool::instance().completed(curl);
 
 	long code;
 	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-	if (code < 200 || code >= 300)
-		throw std::runtime_error(strprintf("HTTP error %ld", code));
+	if ((code < 200 || code >= 300) && code != 304)
+		throw HttpError(code);
+	return code;
+}
+
+std::string Http::responseHeader(const std::string& name) const
+{
+	auto it = responseHeaders.find(name);
+	if (it == responseHeaders.end())
+		return {};
+	else
+		return it->second;
+}
+
+size_t Http::headerCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+	Http *http = (Http *)userdata;
+	std::string_view line(buffer, size * nitems);
+	if (line.substr(0, 5) == "HTTP/") {
+		// new response (redirect or 100-continue)
+		http->responseHeaders.clear();
+		return size * nitems;
+	}
+	size_t colon = line.find(':');
+	if (colon == std::string_view::npos)
+		return size * nitems;
+	std::string name(line.substr(0, colon));
+	for (char& c : name)
+		c = std::tolower(c);
+	std::string_view value = line.substr(colon + 1);
+	while (!value.empty() && std::isspace(value.front()))
+		value.remove_prefix(1);
+	while (!value.empty() && std::isspace(value.back()))
+		value.remove_suffix(1);
+	http->responseHeaders[name] = value;
+	return size * nitems;
+}
+
+size_t Http::writeCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+	const ResponseSink& sink = *(const ResponseSink *)userdata;
+	size_t len = size * nitems;
+	if (sink.str != nullptr)
+	{
+		if (sink.str->size() < sink.maxSize)
+			sink.str->append(buffer, std::min(len, sink.maxSize - sink.str->size()));
+	}
+	else if (sink.callback)
+	{
+		if (!sink.callback(std::string_view(buffer, len)))
+			// aborts the transfer
+			return 0;
+	}
+	return len;
+}
+
+int Http::progressCallback(void *clientp, int64_t dltotal, int64_t dlnow, int64_t ultotal, int64_t ulnow)
+{
+	// a non-zero value aborts the transfer
+	return ((const CancelToken *)clientp)->isCancelled() ? 1 : 0;
+}
+
+void Http::warmUp() {
+	Http http;
+}
+
+HttpStats Http::getStats() {
+	return HttpPool::instance().getStats();
 }
 
 Http::~Http() {
-	curl_easy_cleanup(curl);
+	HttpPool::instance().release(curl);
 }
@@ -21,18 +21,183 @@
 #include <string_view>
 #include <map>
 #include <vector>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <cstdint>
+#include <functional>
 
 using Config = std::map<std::string, std::vector<std::string>>;
 Config loadConfig(std::istream& stream);
 
+// Load the configuration of each module. Called by dcserverInit.
+void discordInit();
+void statusInit();
+
+// Appends the Discord markdown escaped string to out
+void appendEscaped(std::string& out, std::string_view str);
+
+class HttpError : public std::runtime_error
+{
+public:
+	HttpError(long code);
+
+	const long code;
+};
+
+// Error reported by curl before a complete response was received
+class CurlError : public std::runtime_error
+{
+public:
+	CurlError(int code);
+
+	bool timedOut() const;
+	bool cancelled() const;
+
+	const int code;
+};
+
+// Aborts the http requests using it. Can be shared by any number of requests and threads.
+class CancelToken
+{
+public:
+	void cancel()
+	{
+		{
+			std::lock_guard<std::mutex> _(mutex);
+			cancelled = true;
+		}
+		cond.notify_all();
+	}
+	bool isCancelled() const {
+		return cancelled;
+	}
+	// Waits for the given duration. Returns false if cancelled.
+	template<typename Rep, typename Period>
+	bool sleepFor(std::chrono::duration<Rep, Period> duration) const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return !cond.wait_for(lock, duration, [this]() { return cancelled.load(); });
+	}
+
+private:
+	std::atomic_bool cancelled { false };
+	mutable std::mutex mutex;
+	mutable std::condition_variable cond;
+};
+
+struct HttpOptions
+{
+	// A zero duration means no limit
+	std::chrono::milliseconds connectTimeout { 10000 };
+	// Deadline of the whole request, connection included
+	std::chrono::milliseconds timeout { 30000 };
+	const CancelToken *cancelToken = nullptr;
+	// Connects to this unix domain socket instead of the url host
+	std::string unixSocket;
+	// Sends request bodies of at least gzipMinSize bytes with Content-Encoding: gzip.
+	// The server must support it, which isn't the case of Discord.
+	bool gzip = false;
+	size_t gzipMinSize = 1024;
+
+	// Reads the connect-timeout and request-timeout keys, in milliseconds,
+	// and the compress-requests (gzip or none) and compress-min-size keys
+	void load(Config& config);
+};
+
+//
+// Destination of a response body. Bodies are discarded by default.
+//
+class ResponseSink
+{
+public:
+	// Called with each chunk of the body. Returning false aborts the request.
+	using Callback = std::function<bool(std::string_view)>;
+
+	ResponseSink() = default;
+
+	// Stores the body in str, truncated to maxSize bytes.
+	// The string capacity is kept between requests when it's reused.
+	static ResponseSink capture(std::string& str, size_t maxSize = 1024 * 1024) {
+		ResponseSink sink;
+		sink.str = &str;
+		sink.maxSize = maxSize;
+		return sink;
+	}
+	static ResponseSink stream(Callback callback) {
+		ResponseSink sink;
+		sink.callback = std::move(callback);
+		return sink;
+	}
+
+private:
+	std::string *str = nullptr;
+	size_t maxSize = 0;
+	Callback callback;
+
+	friend class Http;
+};
+
+// Validators of a cached resource, sent back in conditional requests
+struct HttpValidators
+{
+	std::string etag;
+	std::string lastModified;
+};
+
+struct HttpStats
+{
+	uint64_t requests = 0;
+	// requests that didn't need a new connection
+	uint64_t reusedConnections = 0;
+	uint64_t handlesCreated = 0;
+	uint64_t timeouts = 0;
+	uint64_t cancelled = 0;
+	// requests sent with a gzip body
+	uint64_t compressedRequests = 0;
+
+	double reuseRatio() const {
+		return requests == 0 ? 0.0 : (double)reusedConnections / requests;
+	}
+};
+
+//
+// Http client. Handles are taken from a process-wide pool and share their
+// DNS cache, TLS sessions and connections so that keep-alive connections are reused.
+//
 class Http
 {
 public:
-	Http();
+	Http(const HttpOptions& options = HttpOptions());
 	~Http();
-	void post(const std::string& url, std::string_view body, std::string_view contentType);
+	// Throws HttpError if the response status isn't 2xx, or CurlError if no response was received.
+	// The response body is handed to the response sink.
+	void post(const std::string& url, std::string_view body, std::string_view contentType,
+			const ResponseSink& response = ResponseSink());
+	void patch(const std::string& url, std::string_view body, std::string_view contentType,
+			const ResponseSink& response = ResponseSink());
+	// If validators isn't null, the request is conditional: returns false if the resource
+	// hasn't been modified. Otherwise returns true and updates the validators from the response.
+	bool get(const std::string& url, const ResponseSink& response = ResponseSink(), HttpValidators *validators = nullptr);
+	// Value of a header of the last response, or an empty string if absent. The name must be lower case.
+	std::string responseHeader(const std::string& name) const;
+
+	static HttpStats getStats();
+	// Initializes libcurl and puts a handle in the pool
+	static void warmUp();
 
 private:
+	// Returns the response status: 2xx or 304 Not Modified
+	long send(const char *method, const std::string& url, std::string_view body, std::string_view contentType,
+			const ResponseSink& response, const std::vector<std::string>& extraHeaders = {});
+	static size_t headerCallback(char *buffer, size_t size, size_t nitems, void *userdata);
+	static size_t writeCallback(char *buffer, size_t size, size_t nitems, void *userdata);
+	static int progressCallback(void *clientp, int64_t dltotal, int64_t dlnow, int64_t ultotal, int64_t ulnow);
+
+	const HttpOptions options;
 	using CURL = void;
 	CURL *curl = nullptr;
+	std::map<std::string, std::string> responseHeaders;
 };
@@ -0,0 +1,127 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "jsonwriter.h"
+#include <cstdio>
+
+JsonWriter& JsonWriter::value(int64_t v)
+{
+	separator();
+	char buf[24];
+	int len = snprintf(buf, sizeof(buf), "%lld", (long long)v);
+	out.append(buf, len);
+	return *this;
+}
+
+// Returns the length of the valid UTF-8 sequence starting at p, or 0 if invalid
+static size_t utf8Length(const uint8_t *p, const uint8_t *end)
+{
+	uint8_t c = p[0];
+	size_t len;
+	uint8_t lo = 0x80, hi = 0xbf;	// valid range of the second byte
+	if (c >= 0xc2 && c <= 0xdf)
+		len = 2;
+	else if (c >= 0xe0 && c <= 0xef) {
+		len = 3;
+		if (c == 0xe0)
+			lo = 0xa0;
+		else if (c == 0xed)
+			hi = 0x9f;
+	}
+	else if (c >= 0xf0 && c <= 0xf4) {
+		len = 4;
+		if (c == 0xf0)
+			lo = 0x90;
+		else if (c == 0xf4)
+			hi = 0x8f;
+	}
+	else
+		return 0;
+	if ((size_t)(end - p) < len)
+		return 0;
+	if (p[1] < lo || p[1] > hi)
+		return 0;
+	for (size_t i = 2; i < len; i++)
+		if (p[i] < 0x80 || p[i] > 0xbf)
+			return 0;
+	return len;
+}
+
+void JsonWriter::string(std::string_view s)
+{
+	static const char hex[] = "0123456789abcdef";
+	out += '"';
+	const uint8_t *p = (const uint8_t *)s.data();
+	const uint8_t *end = p + s.size();
+	while (p < end)
+	{
+		// copy runs of characters that don't need escaping
+		const uint8_t *run = p;
+		while (p < end && *p >= 0x20 && *p < 0x80 && *p != '"' && *p != '\\')
+			p++;
+		if (p != run)
+			out.append((const char *)run, p - run);
+		if (p == end)
+			break;
+
+		uint8_t c = *p;
+		if (c >= 0x80)
+		{
+			size_t len = utf8Length(p, end);
+			if (len == 0) {
+				// U+FFFD replacement character
+				out += "\xef\xbf\xbd";
+				p++;
+			}
+			else {
+				out.append((const char *)p, len);
+				p += len;
+			}
+			continue;
+		}
+		out += '\\';
+		switch (c)
+		{
+		case '"':
+		case '\\':
+			out += c;
+			break;
+		case '\n':
+			out += 'n';
+			break;
+		case '\r':
+			out += 'r';
+			break;
+		case '\t':
+			out += 't';
+			break;
+		case '\b':
+			out += 'b';
+			break;
+		case '\f':
+			out += 'f';
+			break;
+		default:
+			out += "u00";
+			out += hex[c >> 4];
+			out += hex[c & 0xf];
+			break;
+		}
+		p++;
+	}
+	out += '"';
+}
@@ -0,0 +1,114 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+//
+// Minimal streaming JSON writer appending compact JSON to a caller-provided buffer.
+// Strings are assumed to be UTF-8. Invalid sequences are replaced by U+FFFD.
+// Up to 63 levels of nesting are supported.
+//
+class JsonWriter
+{
+public:
+	// The buffer is cleared
+	explicit JsonWriter(std::string& buffer) : out(buffer) {
+		out.clear();
+	}
+
+	JsonWriter& beginObject() {
+		separator();
+		out += '{';
+		push();
+		return *this;
+	}
+	JsonWriter& endObject() {
+		depth--;
+		out += '}';
+		return *this;
+	}
+	JsonWriter& beginArray() {
+		separator();
+		out += '[';
+		push();
+		return *this;
+	}
+	JsonWriter& endArray() {
+		depth--;
+		out += ']';
+		return *this;
+	}
+	JsonWriter& key(std::string_view name) {
+		separator();
+		string(name);
+		out += ':';
+		afterKey = true;
+		return *this;
+	}
+	JsonWriter& value(std::string_view v) {
+		separator();
+		string(v);
+		return *this;
+	}
+	JsonWriter& value(const char *v) {
+		return value(std::string_view(v));
+	}
+	JsonWriter& value(int64_t v);
+	JsonWriter& value(int v) {
+		return value((int64_t)v);
+	}
+	JsonWriter& value(bool v) {
+		separator();
+		out += v ? "true" : "false";
+		return *this;
+	}
+
+	template<typename T>
+	JsonWriter& field(std::string_view name, const T& v) {
+		return key(name).value(v);
+	}
+
+private:
+	void push() {
+		depth++;
+		// no comma before the first element
+		firstElement |= 1ull << depth;
+	}
+	void separator()
+	{
+		if (afterKey) {
+			afterKey = false;
+			return;
+		}
+		if (depth == 0)
+			return;
+		uint64_t bit = 1ull << depth;
+		if (firstElement & bit)
+			firstElement &= ~bit;
+		else
+			out += ',';
+	}
+	void string(std::string_view s);
+
+	std::string& out;
+	uint64_t firstElement = 0;
+	int depth = 0;
+	bool afterKey = false;
+};
@@ -0,0 +1,57 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "messageids.h"
+
+MessageIds::MessageIds(const std::string& path)
+	: db(path)
+{
+	db.exec("PRAGMA journal_mode=WAL");
+	db.exec("PRAGMA synchronous=NORMAL");
+	db.exec("CREATE TABLE IF NOT EXISTS MESSAGE_ID (WEBHOOK VARCHAR NOT NULL, GAME_ID VARCHAR NOT NULL, "
+			"MESSAGE_ID VARCHAR NOT NULL, PRIMARY KEY (WEBHOOK, GAME_ID))");
+}
+
+std::string MessageIds::get(const std::string& url, const std::string& gameId)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	Statement stmt(db, "SELECT MESSAGE_ID FROM MESSAGE_ID WHERE WEBHOOK = ? AND GAME_ID = ?");
+	stmt.bind(1, url);
+	stmt.bind(2, gameId);
+	if (!stmt.step())
+		return {};
+	return stmt.getStringColumn(0);
+}
+
+void MessageIds::set(const std::string& url, const std::string& gameId, const std::string& messageId)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	Statement stmt(db, "INSERT OR REPLACE INTO MESSAGE_ID (WEBHOOK, GAME_ID, MESSAGE_ID) VALUES (?, ?, ?)");
+	stmt.bind(1, url);
+	stmt.bind(2, gameId);
+	stmt.bind(3, messageId);
+	stmt.step();
+}
+
+void MessageIds::remove(const std::string& url, const std::string& gameId)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	Statement stmt(db, "DELETE FROM MESSAGE_ID WHERE WEBHOOK = ? AND GAME_ID = ?");
+	stmt.bind(1, url);
+	stmt.bind(2, gameId);
+	stmt.step();
+}
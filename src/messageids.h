@@ -0,0 +1,39 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "database.hpp"
+#include <mutex>
+#include <string>
+
+//
+// Persistent map of the Discord message kept up to date for each game and webhook
+//
+class MessageIds
+{
+public:
+	MessageIds(const std::string& path);
+
+	// Returns the message id or an empty string if none
+	std::string get(const std::string& url, const std::string& gameId);
+	void set(const std::string& url, const std::string& gameId, const std::string& messageId);
+	void remove(const std::string& url, const std::string& gameId);
+
+private:
+	std::mutex mutex;
+	Database db;
+};
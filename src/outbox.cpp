@@ -0,0 +1,136 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "outbox.h"
+#include <algorithm>
+
+Outbox::Outbox(const std::string& path)
+	: db(path)
+{
+	db.exec("PRAGMA journal_mode=WAL");
+	db.exec("PRAGMA synchronous=NORMAL");
+	db.exec("CREATE TABLE IF NOT EXISTS OUTBOX (ID INTEGER PRIMARY KEY, WEBHOOK VARCHAR NOT NULL, "
+			"PAYLOAD VARCHAR NOT NULL, ATTEMPTS INTEGER NOT NULL, NEXT_ATTEMPT INTEGER NOT NULL)");
+	db.exec("CREATE INDEX IF NOT EXISTS OUTBOX_NEXT_ATTEMPT ON OUTBOX (NEXT_ATTEMPT)");
+}
+
+std::vector<int64_t> Outbox::store(const std::string& url, const std::vector<std::string>& payloads, int64_t nextAttempt)
+{
+	std::vector<int64_t> ids;
+	std::lock_guard<std::mutex> _(mutex);
+	db.exec("BEGIN");
+	try {
+		Statement stmt(db, "INSERT INTO OUTBOX (WEBHOOK, PAYLOAD, ATTEMPTS, NEXT_ATTEMPT) VALUES (?, ?, 0, ?)");
+		for (const std::string& payload : payloads)
+		{
+			stmt.bind(1, url);
+			stmt.bind(2, payload);
+			stmt.bind(3, nextAttempt);
+			stmt.step();
+			ids.push_back(sqlite3_last_insert_rowid(db.db));
+		}
+	} catch (...) {
+		db.exec("ROLLBACK");
+		throw;
+	}
+	db.exec("COMMIT");
+	return ids;
+}
+
+// "(?, ?, ...)" with one parameter per url
+static std::string inList(size_t count)
+{
+	std::string list = "(";
+	for (size_t i = 0; i < count; i++)
+		list += i == 0 ? "?" : ", ?";
+	return list + ')';
+}
+
+std::vector<Outbox::Entry> Outbox::claim(const std::vector<std::string>& urls, int64_t now, int64_t lease, int limit)
+{
+	std::vector<Entry> entries;
+	if (urls.empty())
+		return entries;
+	std::lock_guard<std::mutex> _(mutex);
+	// take the write lock now so that no other process can claim the same messages
+	db.exec("BEGIN IMMEDIATE");
+	try {
+		std::string sql = "SELECT ID, WEBHOOK, PAYLOAD, ATTEMPTS FROM OUTBOX WHERE NEXT_ATTEMPT <= ? AND WEBHOOK IN "
+				+ inList(urls.size()) + " ORDER BY ID LIMIT ?";
+		Statement select(db, sql.c_str());
+		int idx = 1;
+		select.bind(idx++, now);
+		for (const std::string& url : urls)
+			select.bind(idx++, url);
+		select.bind(idx, limit);
+		while (select.step())
+			entries.push_back({ select.getInt64Column(0), select.getStringColumn(1), select.getStringColumn(2), select.getIntColumn(3) });
+
+		Statement update(db, "UPDATE OUTBOX SET NEXT_ATTEMPT = ? WHERE ID = ?");
+		for (const Entry& entry : entries)
+		{
+			update.bind(1, now + lease);
+			update.bind(2, entry.id);
+			update.step();
+		}
+	} catch (...) {
+		db.exec("ROLLBACK");
+		throw;
+	}
+	db.exec("COMMIT");
+	return entries;
+}
+
+int64_t Outbox::nextAttempt(const std::vector<std::string>& urls)
+{
+	if (urls.empty())
+		return -1;
+	std::lock_guard<std::mutex> _(mutex);
+	std::string sql = "SELECT COALESCE(MIN(NEXT_ATTEMPT), -1) FROM OUTBOX WHERE WEBHOOK IN " + inList(urls.size());
+	Statement stmt(db, sql.c_str());
+	for (size_t i = 0; i < urls.size(); i++)
+		stmt.bind(i + 1, urls[i]);
+	if (!stmt.step())
+		return -1;
+	return stmt.getInt64Column(0);
+}
+
+void Outbox::remove(int64_t id)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	Statement stmt(db, "DELETE FROM OUTBOX WHERE ID = ?");
+	stmt.bind(1, id);
+	stmt.step();
+}
+
+void Outbox::reschedule(int64_t id, int attempts, int64_t nextAttempt)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	Statement stmt(db, "UPDATE OUTBOX SET ATTEMPTS = ?, NEXT_ATTEMPT = ? WHERE ID = ?");
+	stmt.bind(1, attempts);
+	stmt.bind(2, nextAttempt);
+	stmt.bind(3, id);
+	stmt.step();
+}
+
+int64_t Outbox::backoff(int attempts)
+{
+	// 5 s, 10 s, 20 s, ... up to 1 hour
+	if (attempts <= 0)
+		return 0;
+	return std::min<int64_t>(5ll << std::min(attempts - 1, 20), 3600);
+}
@@ -0,0 +1,63 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "database.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// Persistent store of webhook messages waiting to be delivered.
+// Messages are written before being posted and removed once delivered so that
+// failed and in-flight messages survive a restart.
+// The database can be shared by several processes: messages are leased to the process
+// sending them, and each process only handles the messages of the webhooks it knows.
+// Times are in seconds since the epoch.
+//
+class Outbox
+{
+public:
+	struct Entry
+	{
+		int64_t id;
+		std::string url;
+		std::string payload;
+		int attempts;
+	};
+
+	Outbox(const std::string& path);
+
+	// Stores messages in a single transaction and returns their ids.
+	// They won't be claimed before nextAttempt.
+	std::vector<int64_t> store(const std::string& url, const std::vector<std::string>& payloads, int64_t nextAttempt);
+	// Returns the due messages of the given webhooks, oldest first, and leases them:
+	// they won't be claimed again before now + lease unless rescheduled.
+	std::vector<Entry> claim(const std::vector<std::string>& urls, int64_t now, int64_t lease, int limit);
+	// Time of the next due message of the given webhooks, or -1 if none
+	int64_t nextAttempt(const std::vector<std::string>& urls);
+	void remove(int64_t id);
+	void reschedule(int64_t id, int attempts, int64_t nextAttempt);
+
+	// Delay before the next attempt: exponential backoff capped to 1 hour
+	static int64_t backoff(int attempts);
+
+private:
+	std::mutex mutex;
+	Database db;
+};
@@ -0,0 +1,74 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "ratelimit.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+static RateLimiter::clock::duration toDuration(double seconds) {
+	return duration_cast<RateLimiter::clock::duration>(duration<double>(seconds));
+}
+
+RateLimiter::RateLimiter(int limit, clock::duration period)
+	: limit(limit), period(period), remaining(limit)
+{
+}
+
+RateLimiter::clock::time_point RateLimiter::acquire(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (now >= resetTime && remaining < limit) {
+		remaining = limit;
+		resetTime = now + period;
+	}
+	if (remaining <= 0)
+		return resetTime;
+	if (remaining == limit)
+		// first request of a new window
+		resetTime = now + period;
+	remaining--;
+	return now;
+}
+
+RateLimiter::clock::time_point RateLimiter::readyTime(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (remaining > 0 || now >= resetTime)
+		return now;
+	else
+		return resetTime;
+}
+
+void RateLimiter::update(int limit, int remaining, double resetAfter, clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (limit > 0)
+		this->limit = limit;
+	if (resetAfter >= 0)
+		resetTime = now + toDuration(resetAfter);
+	if (remaining >= 0)
+		// other requests may still be in flight so never give back slots
+		this->remaining = std::min(this->remaining, remaining);
+}
+
+void RateLimiter::block(double retryAfter, clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	remaining = 0;
+	resetTime = std::max(resetTime, now + toDuration(std::max(retryAfter, 0.0)));
+}
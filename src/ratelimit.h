@@ -0,0 +1,51 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <chrono>
+#include <mutex>
+
+//
+// Client-side view of a Discord rate limit bucket.
+// Requests are spread so that the bucket is never exhausted and
+// the limits advertised by the server are honored.
+//
+class RateLimiter
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	// Discord allows 5 requests every 2 seconds per webhook
+	RateLimiter(int limit = 5, clock::duration period = std::chrono::seconds(2));
+
+	// Reserves a request slot and returns the time at which the request can be sent.
+	// If this time is in the future, the slot isn't reserved and acquire() must be called again.
+	clock::time_point acquire(clock::time_point now = clock::now());
+	// Returns the time at which a slot will be available without reserving it
+	clock::time_point readyTime(clock::time_point now = clock::now());
+	// Updates the bucket state from X-RateLimit-* headers. Negative values are ignored.
+	void update(int limit, int remaining, double resetAfter, clock::time_point now = clock::now());
+	// The server replied with 429 Too Many Requests
+	void block(double retryAfter, clock::time_point now = clock::now());
+
+private:
+	std::mutex mutex;
+	int limit;
+	clock::duration period;
+	int remaining;
+	clock::time_point resetTime {};
+};
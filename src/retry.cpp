@@ -0,0 +1,218 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "retry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <curl/curl.h>
+
+bool isRetryable(const std::exception& e)
+{
+	if (const HttpError *httpError = dynamic_cast<const HttpError *>(&e))
+	{
+		switch (httpError->code)
+		{
+		case 408:	// Request Timeout
+		case 425:	// Too Early
+		case 429:	// Too Many Requests
+			return true;
+		case 501:	// Not Implemented
+		case 505:	// HTTP Version Not Supported
+			return false;
+		default:
+			return httpError->code >= 500;
+		}
+	}
+	if (const CurlError *curlError = dynamic_cast<const CurlError *>(&e))
+	{
+		switch (curlError->code)
+		{
+		case CURLE_UNSUPPORTED_PROTOCOL:
+		case CURLE_URL_MALFORMAT:
+		case CURLE_NOT_BUILT_IN:
+		case CURLE_SSL_CERTPROBLEM:
+		case CURLE_SSL_CIPHER:
+		case CURLE_PEER_FAILED_VERIFICATION:
+		case CURLE_BAD_CONTENT_ENCODING:
+		case CURLE_FILESIZE_EXCEEDED:
+		case CURLE_TOO_MANY_REDIRECTS:
+			return false;
+		default:
+			return true;
+		}
+	}
+	// circuit open, i/o errors...
+	return true;
+}
+
+bool CircuitBreaker::allow(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (failures < failureThreshold)
+		return true;
+	if (now < openUntil || probing)
+		return false;
+	// half-open: let one request through
+	probing = true;
+	return true;
+}
+
+void CircuitBreaker::success()
+{
+	std::lock_guard<std::mutex> _(mutex);
+	failures = 0;
+	probing = false;
+}
+
+void CircuitBreaker::aborted()
+{
+	std::lock_guard<std::mutex> _(mutex);
+	probing = false;
+}
+
+void CircuitBreaker::failure(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	failures++;
+	if (failures >= failureThreshold)
+	{
+		if (failures == failureThreshold || probing)
+			fprintf(stderr, "Circuit breaker opened after %d failures\n", failures);
+		openUntil = now + openTime;
+	}
+	probing = false;
+}
+
+CircuitBreaker::State CircuitBreaker::state(clock::time_point now)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	if (failures < failureThreshold)
+		return State::Closed;
+	if (now < openUntil && !probing)
+		return State::Open;
+	return State::HalfOpen;
+}
+
+std::string CircuitBreaker::urlHost(const std::string& url)
+{
+	size_t start = url.find("://");
+	start = start == std::string::npos ? 0 : start + 3;
+	size_t end = url.find_first_of("/?#", start);
+	std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+	// strip user info
+	size_t at = host.rfind('@');
+	if (at != std::string::npos)
+		host = host.substr(at + 1);
+	return host;
+}
+
+CircuitBreaker& CircuitBreaker::forUrl(const std::string& url, int failureThreshold, clock::duration openTime)
+{
+	struct Registry
+	{
+		std::mutex mutex;
+		std::map<std::string, std::unique_ptr<CircuitBreaker>> breakers;
+	};
+	// Never destroyed so that dispatcher threads draining at exit can still use it
+	static Registry *registry = new Registry();
+
+	std::string host = urlHost(url);
+	std::lock_guard<std::mutex> _(registry->mutex);
+	std::unique_ptr<CircuitBreaker>& breaker = registry->breakers[host];
+	if (breaker == nullptr)
+		breaker = std::make_unique<CircuitBreaker>(failureThreshold, openTime);
+	return *breaker;
+}
+
+void RetryPolicy::load(Config& config)
+{
+	auto getInt = [&config](const char *key, int& value) {
+		if (config.count(key) != 0 && !config[key].empty())
+			value = std::max(0, atoi(config[key][0].c_str()));
+	};
+	getInt("max-retries", maxRetries);
+	int v = baseDelay.count();
+	getInt("retry-delay", v);
+	baseDelay = std::chrono::milliseconds(v);
+	v = maxDelay.count();
+	getInt("retry-max-delay", v);
+	maxDelay = std::chrono::milliseconds(v);
+	getInt("breaker-threshold", breakerThreshold);
+	v = breakerOpenTime.count();
+	getInt("breaker-open-time", v);
+	breakerOpenTime = std::chrono::seconds(v);
+}
+
+std::chrono::milliseconds RetryPolicy::delay(int retry) const
+{
+	thread_local std::mt19937 rng(std::random_device{}());
+	int64_t ceiling = baseDelay.count() << std::clamp(retry - 1, 0, 20);
+	ceiling = std::min<int64_t>(ceiling, maxDelay.count());
+	if (ceiling <= 0)
+		return std::chrono::milliseconds(0);
+	return std::chrono::milliseconds(std::uniform_int_distribution<int64_t>(0, ceiling)(rng));
+}
+
+void retryRequest(const std::string& url, const RetryPolicy& policy, const std::function<void()>& request,
+		const CancelToken *cancelToken)
+{
+	CircuitBreaker *breaker = nullptr;
+	if (policy.breakerThreshold > 0)
+		breaker = &CircuitBreaker::forUrl(url, policy.breakerThreshold, policy.breakerOpenTime);
+	for (int retry = 0;; retry++)
+	{
+		if (breaker != nullptr && !breaker->allow())
+			throw CircuitOpenError(CircuitBreaker::urlHost(url));
+		try {
+			request();
+			if (breaker != nullptr)
+				breaker->success();
+			return;
+		} catch (const std::exception& e) {
+			const HttpError *httpError = dynamic_cast<const HttpError *>(&e);
+			const CurlError *curlError = dynamic_cast<const CurlError *>(&e);
+			bool rateLimited = httpError != nullptr && httpError->code == 429;
+			bool retryable = isRetryable(e);
+			if (breaker != nullptr)
+			{
+				if (curlError != nullptr && curlError->cancelled())
+					breaker->aborted();
+				// other errors mean that the host is reachable
+				else if (retryable && !rateLimited)
+					breaker->failure();
+				else
+					breaker->success();
+			}
+			if (!retryable || retry >= policy.maxRetries || (!rateLimited && !policy.retryErrors)
+					|| (cancelToken != nullptr && cancelToken->isCancelled()))
+				throw;
+			if (!rateLimited)
+			{
+				std::chrono::milliseconds delay = policy.delay(retry + 1);
+				if (cancelToken == nullptr)
+					std::this_thread::sleep_for(delay);
+				else if (!cancelToken->sleepFor(delay))
+					throw;
+			}
+		}
+	}
+}
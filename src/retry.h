@@ -0,0 +1,104 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "internal.h"
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Whether a failed request may succeed if sent again later:
+// network errors, timeouts, rate limiting and server errors are retryable,
+// client errors and invalid urls aren't.
+bool isRetryable(const std::exception& e);
+
+//
+// Stops sending requests to a host after consecutive failures.
+// Once open, the circuit lets a single request through after openTime. If this
+// request succeeds the circuit is closed again, otherwise it stays open for another period.
+//
+class CircuitBreaker
+{
+public:
+	using clock = std::chrono::steady_clock;
+	enum class State { Closed, Open, HalfOpen };
+
+	CircuitBreaker(int failureThreshold = 5, clock::duration openTime = std::chrono::seconds(30))
+		: failureThreshold(failureThreshold), openTime(openTime) {}
+
+	// Returns false if the request must not be sent
+	bool allow(clock::time_point now = clock::now());
+	void success();
+	void failure(clock::time_point now = clock::now());
+	// The request was cancelled and tells nothing about the host
+	void aborted();
+	State state(clock::time_point now = clock::now());
+
+	// Breaker shared by all the requests to the host of an url.
+	// The settings are only used when the breaker of this host is created.
+	static CircuitBreaker& forUrl(const std::string& url, int failureThreshold, clock::duration openTime);
+	// Host and port of an url
+	static std::string urlHost(const std::string& url);
+
+private:
+	std::mutex mutex;
+	const int failureThreshold;
+	const clock::duration openTime;
+	int failures = 0;
+	clock::time_point openUntil {};
+	bool probing = false;
+};
+
+// The circuit breaker of the host is open
+class CircuitOpenError : public std::runtime_error
+{
+public:
+	CircuitOpenError(const std::string& host)
+		: std::runtime_error("circuit open for " + host) {}
+};
+
+struct RetryPolicy
+{
+	// Retries after the first attempt
+	int maxRetries = 3;
+	// Whether failures other than 429 Too Many Requests are retried. Disabled when the caller
+	// reschedules failed requests itself, as the outbox does, so that workers don't sleep.
+	bool retryErrors = true;
+	// Exponential backoff with full jitter: before the nth retry, wait a random
+	// delay between 0 and min(maxDelay, baseDelay * 2^(n-1))
+	std::chrono::milliseconds baseDelay { 500 };
+	std::chrono::milliseconds maxDelay { 10000 };
+	// Consecutive failures opening the circuit breaker of a host, 0 to disable it
+	int breakerThreshold = 5;
+	std::chrono::seconds breakerOpenTime { 30 };
+
+	// Reads the max-retries, retry-delay, retry-max-delay (ms), breaker-threshold and breaker-open-time (s) keys
+	void load(Config& config);
+	// Delay before the given retry (1 for the first one)
+	std::chrono::milliseconds delay(int retry) const;
+};
+
+// Calls request until it succeeds, fails with a non-retryable error or the policy gives up,
+// in which case the last error is rethrown.
+// 429 Too Many Requests responses are retried immediately: the request is expected
+// to wait for the rate limit itself. They don't count as host failures.
+// The backoff delay is interrupted if cancelToken is cancelled.
+// Throws CircuitOpenError without calling request if the circuit of the url host is open.
+void retryRequest(const std::string& url, const RetryPolicy& policy, const std::function<void()>& request,
+		const CancelToken *cancelToken = nullptr);
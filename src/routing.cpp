@@ -0,0 +1,76 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "routing.h"
+#include <algorithm>
+
+static const std::string WEBHOOK_PREFIX = "webhook.";
+static const std::string GROUP_PREFIX = "group.";
+
+int RoutingTable::addWebhook(const std::string& url)
+{
+	auto it = std::find(urls.begin(), urls.end(), url);
+	if (it != urls.end())
+		return it - urls.begin();
+	urls.push_back(url);
+	return urls.size() - 1;
+}
+
+void RoutingTable::setDefaultWebhook(const std::string& url)
+{
+	if (url.empty())
+		defaultRoute = NoRoute;
+	else
+		defaultRoute = addWebhook(url);
+}
+
+void RoutingTable::load(Config& config)
+{
+	if (config.count("webhook") != 0)
+		setDefaultWebhook(config["webhook"][0]);
+	// group routes first so that game routes override them
+	for (const auto& [key, values] : config)
+	{
+		if (key.substr(0, GROUP_PREFIX.length()) != GROUP_PREFIX)
+			continue;
+		std::string webhookKey = WEBHOOK_PREFIX + key.substr(GROUP_PREFIX.length());
+		auto it = config.find(webhookKey);
+		if (it == config.end() || it->second.empty())
+			continue;
+		int route = addWebhook(it->second[0]);
+		for (const auto& gameId : values)
+			gameRoutes.emplace(gameId, route);
+	}
+	for (const auto& [key, values] : config)
+	{
+		if (key.substr(0, WEBHOOK_PREFIX.length()) != WEBHOOK_PREFIX || values.empty())
+			continue;
+		std::string name = key.substr(WEBHOOK_PREFIX.length());
+		if (config.count(GROUP_PREFIX + name) != 0)
+			continue;
+		gameRoutes[name] = addWebhook(values[0]);
+	}
+}
+
+int RoutingTable::route(const std::string& gameId) const
+{
+	auto it = gameRoutes.find(gameId);
+	if (it != gameRoutes.end())
+		return it->second;
+	else
+		return defaultRoute;
+}
@@ -0,0 +1,54 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "internal.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//
+// Maps game ids to Discord webhooks.
+//  webhook = <url>					default webhook
+//  webhook.<gameId> = <url>		webhook of a game
+//  group.<name> = <gameId>, ...	defines a group of games
+//  webhook.<name> = <url>			webhook of a group
+// A game webhook takes precedence over a group webhook.
+//
+class RoutingTable
+{
+public:
+	static constexpr int NoRoute = -1;
+
+	void load(Config& config);
+	void setDefaultWebhook(const std::string& url);
+
+	// Returns the route index of a game or NoRoute if it has none
+	int route(const std::string& gameId) const;
+	// Distinct webhooks, indexed by route
+	const std::vector<std::string>& webhooks() const {
+		return urls;
+	}
+
+private:
+	int addWebhook(const std::string& url);
+
+	std::vector<std::string> urls;
+	std::unordered_map<std::string, int> gameRoutes;
+	int defaultRoute = NoRoute;
+};
@@ -0,0 +1,304 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "sink.h"
+#include "internal.h"
+#include "games.hpp"
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <stdio.h>
+#include <syslog.h>
+#include <time.h>
+
+// Discord message limits
+static constexpr size_t MAX_EMBEDS = 10;
+static constexpr size_t MAX_CONTENT_LENGTH = 2000;
+static constexpr size_t MAX_EMBEDS_LENGTH = 6000;
+
+static int intHeader(const Http& http, const std::string& name)
+{
+	std::string v = http.responseHeader(name);
+	return v.empty() ? -1 : atoi(v.c_str());
+}
+
+static double doubleHeader(const Http& http, const std::string& name)
+{
+	std::string v = http.responseHeader(name);
+	return v.empty() ? -1.0 : strtod(v.c_str(), nullptr);
+}
+
+void sendRateLimited(Dispatcher::Route& route, const std::string& url, const std::string& body,
+		const RetryPolicy& retryPolicy, const HttpOptions& httpOptions, bool patch, std::string *response)
+{
+	RateLimiter& limiter = route.rateLimiter;
+	Http http(httpOptions);
+	ResponseSink responseSink = response != nullptr ? ResponseSink::capture(*response) : ResponseSink();
+	retryRequest(url, retryPolicy, [&]() {
+		auto sendTime = limiter.acquire();
+		while (sendTime > RateLimiter::clock::now())
+		{
+			if (httpOptions.cancelToken == nullptr)
+				std::this_thread::sleep_until(sendTime);
+			else if (!httpOptions.cancelToken->sleepFor(sendTime - RateLimiter::clock::now()))
+				// cancelled: the request below fails without being sent
+				break;
+			sendTime = limiter.acquire();
+		}
+		try {
+			if (patch)
+				http.patch(url, body, "application/json", responseSink);
+			else
+				http.post(url, body, "application/json", responseSink);
+			limiter.update(intHeader(http, "x-ratelimit-limit"), intHeader(http, "x-ratelimit-remaining"),
+					doubleHeader(http, "x-ratelimit-reset-after"));
+		} catch (const HttpError& e) {
+			if (e.code == 429)
+			{
+				double retryAfter = doubleHeader(http, "retry-after");
+				if (retryAfter < 0)
+					retryAfter = doubleHeader(http, "x-ratelimit-reset-after");
+				limiter.block(retryAfter < 0 ? 1.0 : retryAfter);
+			}
+			throw;
+		}
+	}, httpOptions.cancelToken);
+}
+
+static std::string_view gameName(const std::string& gameId)
+{
+	const GameInfo *game = findGame(gameId);
+	return game != nullptr ? game->name : std::string_view(gameId);
+}
+
+//
+// Discord
+//
+void DiscordSink::writeEmbed(JsonWriter& writer, const PendingNotif& pending)
+{
+	const Notif& notif = pending.notif;
+	std::string_view gameName = pending.gameId;
+	std::string_view gamePic = "https://dcnet.flyca.st/gamepic/unknown.jpg";
+	const GameInfo *game = findGame(pending.gameId);
+	if (game != nullptr) {
+		gameName = game->name;
+		gamePic = game->thumbnail;
+	}
+
+	writer.beginObject()
+		.key("author").beginObject()
+			.field("name", gameName)
+			.field("icon_url", gamePic)
+		.endObject()
+		.field("title", notif.embed.title)
+		.field("description", notif.embed.text)
+		.field("color", 9118205)
+	.endObject();
+}
+
+void DiscordSink::serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads)
+{
+	thread_local std::string content;
+	size_t count = 0;
+	size_t i = 0;
+	while (i < batch.size())
+	{
+		const size_t first = i;
+		content.clear();
+		size_t embedsLength = 0;
+		for (; i < batch.size() && i - first < MAX_EMBEDS; i++)
+		{
+			const Notif& notif = batch[i].notif;
+			size_t contentLength = content.length() + notif.content.length() + 1;
+			// leave some room for the author name
+			size_t embedLength = notif.embed.title.length() + notif.embed.text.length() + 64;
+			if (i != first
+					&& (contentLength > MAX_CONTENT_LENGTH || embedsLength + embedLength > MAX_EMBEDS_LENGTH))
+				break;
+			if (!notif.content.empty())
+			{
+				if (!content.empty())
+					content += '\n';
+				content += notif.content;
+			}
+			embedsLength += embedLength;
+		}
+		if (count == payloads.size())
+			payloads.emplace_back();
+		JsonWriter writer(payloads[count++]);
+		writer.beginObject()
+			.field("content", content)
+			.key("embeds").beginArray();
+		for (size_t j = first; j < i; j++)
+			writeEmbed(writer, batch[j]);
+		writer.endArray().endObject();
+	}
+	payloads.resize(count);
+}
+
+void DiscordSink::send(Dispatcher::Route& route, const std::string& payload) {
+	sendRateLimited(route, route.url, payload, retryPolicy, httpOptions);
+}
+
+//
+// Generic JSON
+//
+static const char *priorityName(NotifPriority priority)
+{
+	switch (priority)
+	{
+	case NotifPriority::Low:
+		return "low";
+	case NotifPriority::High:
+		return "high";
+	default:
+		return "normal";
+	}
+}
+
+static void writeNotif(JsonWriter& writer, const PendingNotif& pending, int64_t timestamp)
+{
+	const Notif& notif = pending.notif;
+	writer.beginObject()
+		.field("gameId", pending.gameId)
+		.field("game", gameName(pending.gameId))
+		.field("timestamp", timestamp)
+		.field("priority", priorityName(notif.priority))
+		.field("content", notif.content)
+		.field("title", notif.embed.title)
+		.field("text", notif.embed.text)
+	.endObject();
+}
+
+static void serializeBatch(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads)
+{
+	payloads.resize(1);
+	int64_t now = time(nullptr);
+	JsonWriter writer(payloads[0]);
+	writer.beginObject()
+		.key("notifications").beginArray();
+	for (const PendingNotif& pending : batch)
+		writeNotif(writer, pending, now);
+	writer.endArray().endObject();
+}
+
+void JsonSink::serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) {
+	serializeBatch(batch, payloads);
+}
+
+void JsonSink::send(Dispatcher::Route& route, const std::string& payload) {
+	sendRateLimited(route, url, payload, retryPolicy, httpOptions);
+}
+
+//
+// File
+//
+void FileSink::serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads)
+{
+	thread_local std::string line;
+	payloads.resize(1);
+	payloads[0].clear();
+	int64_t now = time(nullptr);
+	for (const PendingNotif& pending : batch)
+	{
+		JsonWriter writer(line);
+		writeNotif(writer, pending, now);
+		payloads[0] += line;
+		payloads[0] += '\n';
+	}
+}
+
+void FileSink::send(Dispatcher::Route&, const std::string& payload)
+{
+	std::lock_guard<std::mutex> _(mutex);
+	FILE *f = fopen(path.c_str(), "a");
+	if (f == nullptr)
+		throw std::runtime_error(path + ": " + strerror(errno));
+	size_t written = fwrite(payload.data(), 1, payload.length(), f);
+	fclose(f);
+	if (written != payload.length())
+		throw std::runtime_error(path + ": write failed");
+}
+
+//
+// Syslog
+//
+void SyslogSink::serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads)
+{
+	payloads.resize(batch.size());
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		const Notif& notif = batch[i].notif;
+		std::string& payload = payloads[i];
+		payload = gameName(batch[i].gameId);
+		for (const std::string *s : { &notif.content, &notif.embed.title, &notif.embed.text })
+		{
+			if (s->empty())
+				continue;
+			payload += " | ";
+			payload += *s;
+		}
+	}
+}
+
+void SyslogSink::send(Dispatcher::Route&, const std::string& payload) {
+	syslog(LOG_NOTICE, "%s: %s", ident.c_str(), payload.c_str());
+}
+
+//
+// Memory
+//
+static std::mutex memoryMutex;
+static std::map<std::string, std::vector<std::string>> memoryPayloads;
+
+void MemorySink::serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) {
+	serializeBatch(batch, payloads);
+}
+
+void MemorySink::send(Dispatcher::Route&, const std::string& payload)
+{
+	std::lock_guard<std::mutex> _(memoryMutex);
+	memoryPayloads[name].push_back(payload);
+}
+
+std::vector<std::string> MemorySink::take(const std::string& name)
+{
+	std::lock_guard<std::mutex> _(memoryMutex);
+	std::vector<std::string> payloads;
+	payloads.swap(memoryPayloads[name]);
+	return payloads;
+}
+
+std::unique_ptr<Sink> createSink(const std::string& url, const RetryPolicy& retryPolicy, const HttpOptions& httpOptions)
+{
+	auto hasPrefix = [&url](std::string_view prefix) {
+		return std::string_view(url).substr(0, prefix.length()) == prefix;
+	};
+	if (hasPrefix("json:"))
+		return std::make_unique<JsonSink>(url.substr(5), retryPolicy, httpOptions);
+	if (hasPrefix("file:"))
+		return std::make_unique<FileSink>(url.substr(5));
+	if (url == "syslog")
+		return std::make_unique<SyslogSink>("dcnet");
+	if (hasPrefix("syslog:"))
+		return std::make_unique<SyslogSink>(url.substr(7));
+	if (hasPrefix("memory:"))
+		return std::make_unique<MemorySink>(url.substr(7));
+	return std::make_unique<DiscordSink>(retryPolicy, httpOptions);
+}
@@ -0,0 +1,147 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "dispatcher.h"
+#include "internal.h"
+#include "retry.h"
+#include "jsonwriter.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// Destination of the notifications of a route.
+// A worker serializes each batch into payloads, which are then sent.
+// Payloads that failed to be sent may be sent again later from the outbox.
+//
+class Sink
+{
+public:
+	virtual ~Sink() = default;
+
+	// Serializes a batch into payloads, reusing its strings, and resizes it to the number of payloads
+	virtual void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) = 0;
+	// Throws if the payload couldn't be delivered
+	virtual void send(Dispatcher::Route& route, const std::string& payload) = 0;
+	// Whether payloads are kept in the outbox until delivered
+	virtual bool persistent() const {
+		return false;
+	}
+};
+
+// Creates the sink of a route url:
+//   json:<url>        generic JSON webhook
+//   file:<path>       JSON lines appended to a file
+//   syslog[:<ident>]  syslog messages
+//   memory:<name>     kept in memory, for tests and benchmarks
+// Any other url is a Discord webhook.
+// Failed requests are retried according to retryPolicy.
+std::unique_ptr<Sink> createSink(const std::string& url, const RetryPolicy& retryPolicy,
+		const HttpOptions& httpOptions = HttpOptions());
+
+// Sends a JSON request while staying within the rate limit of the route.
+// Requests rejected with 429 Too Many Requests are retried once the server allows it.
+// Other failures are retried with backoff if the policy allows it.
+// Waits are cancelled by the cancel token of the http options.
+// The response body is stored in response if not null.
+void sendRateLimited(Dispatcher::Route& route, const std::string& url, const std::string& body,
+		const RetryPolicy& retryPolicy, const HttpOptions& httpOptions, bool patch = false,
+		std::string *response = nullptr);
+
+// Merges notifications into as few messages as Discord limits allow
+class DiscordSink : public Sink
+{
+public:
+	DiscordSink(const RetryPolicy& retryPolicy, const HttpOptions& httpOptions = HttpOptions())
+		: retryPolicy(retryPolicy), httpOptions(httpOptions) {}
+
+	void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) override;
+	void send(Dispatcher::Route& route, const std::string& payload) override;
+	bool persistent() const override {
+		return true;
+	}
+
+	static void writeEmbed(JsonWriter& writer, const PendingNotif& pending);
+
+private:
+	const RetryPolicy retryPolicy;
+	const HttpOptions httpOptions;
+};
+
+// Posts each batch as {"notifications":[...]}
+class JsonSink : public Sink
+{
+public:
+	JsonSink(const std::string& url, const RetryPolicy& retryPolicy, const HttpOptions& httpOptions = HttpOptions())
+		: url(url), retryPolicy(retryPolicy), httpOptions(httpOptions) {}
+
+	void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) override;
+	void send(Dispatcher::Route& route, const std::string& payload) override;
+	bool persistent() const override {
+		return true;
+	}
+
+private:
+	const std::string url;
+	const RetryPolicy retryPolicy;
+	const HttpOptions httpOptions;
+};
+
+// Appends one JSON object per notification and line
+class FileSink : public Sink
+{
+public:
+	FileSink(const std::string& path) : path(path) {}
+
+	void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) override;
+	void send(Dispatcher::Route& route, const std::string& payload) override;
+
+private:
+	const std::string path;
+	std::mutex mutex;
+};
+
+// Logs one line per notification
+class SyslogSink : public Sink
+{
+public:
+	SyslogSink(const std::string& ident) : ident(ident) {}
+
+	void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) override;
+	void send(Dispatcher::Route& route, const std::string& payload) override;
+
+private:
+	const std::string ident;
+};
+
+// Keeps the payloads of each batch, in the same format as JsonSink
+class MemorySink : public Sink
+{
+public:
+	MemorySink(const std::string& name) : name(name) {}
+
+	void serialize(const std::vector<PendingNotif>& batch, std::vector<std::string>& payloads) override;
+	void send(Dispatcher::Route& route, const std::string& payload) override;
+
+	// Returns and forgets the payloads sent to the memory sinks with the given name
+	static std::vector<std::string> take(const std::string& name);
+
+private:
+	const std::string name;
+};
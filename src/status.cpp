@@ -17,13 +17,16 @@
 */
 #include "status.h"
 #include "status.hpp"
-#include "json.hpp"
 #include "internal.h"
+#include "jsonwriter.h"
+#include "retry.h"
 #include <string>
 #include <string_view>
+#include <vector>
 #include <stdio.h>
 #include <time.h>
 #include <fstream>
+#include <mutex>
 #include <stdexcept>
 
 #ifndef STATUSDIR
@@ -34,42 +37,60 @@
 #endif
 #define CONF_FILE CONFDIR "/status.conf"
 
-static bool initialized;
+static std::once_flag initFlag;
 static std::string statusUrl;
 static std::string statusDir;
 static int updateInterval = 5 * 60; // default 5 min
-static nlohmann::json statusArray;
+static HttpOptions httpOptions;
+static RetryPolicy retryPolicy;
 
-static nlohmann::json jsonStatus(std::string_view gameId, int playerCount, int gameCount)
+struct Status
 {
-	nlohmann::json status = {
-		{ "gameId", gameId },
-		{ "timestamp", time(nullptr) },
-	};
-	if (playerCount >= 0)
-		status["playerCount"] = playerCount;
-	if (gameCount >= 0)
-		status["gameCount"] = gameCount;
-	return status;
+	std::string gameId;
+	time_t timestamp;
+	int playerCount;
+	int gameCount;
+};
+static std::vector<Status> statusArray;
+static std::string statusJson;
+
+static void writeStatus(JsonWriter& writer, const Status& status)
+{
+	writer.beginObject()
+		.field("gameId", status.gameId)
+		.field("timestamp", (int64_t)status.timestamp);
+	if (status.playerCount >= 0)
+		writer.field("playerCount", status.playerCount);
+	if (status.gameCount >= 0)
+		writer.field("gameCount", status.gameCount);
+	writer.endObject();
 }
 
-static void init()
+static void load()
 {
-	if (initialized)
-		return;
-	initialized = true;
 	std::ifstream ifs(CONF_FILE);
 	if (ifs.fail())
 		return;
 	Config config = loadConfig(ifs);
 	if (config.count("status-url") != 0)
 		statusUrl = config["status-url"][0];
+	if (statusUrl.substr(0, 5) == "unix:")
+	{
+		// local collector listening on a unix domain socket
+		httpOptions.unixSocket = statusUrl.substr(5);
+		statusUrl = "http://localhost";
+	}
 	if (config.count("update-interval") != 0)
 	{
 		int v = atoi(config["update-interval"][0].c_str());
 		if (v != 0)
 			updateInterval = v;
 	}
+	httpOptions.load(config);
+	retryPolicy.load(config);
+	// statusCommit() runs on the game server thread: don't block it with backoff delays.
+	// The next commit is the retry. Only the circuit breaker is used.
+	retryPolicy.maxRetries = 0;
 	if (config.count("status-dir") != 0)
 		statusDir = config["status-dir"][0];
 	if (statusDir.empty())
@@ -78,20 +99,34 @@ static void init()
 		statusDir += '/';
 }
 
+static void init() {
+	std::call_once(initFlag, load);
+}
+
+void statusInit() {
+	init();
+}
+
 void statusUpdate(std::string_view gameId, int playerCount, int gameCount)
 {
 	init();
-	nlohmann::json json = jsonStatus(gameId, playerCount, gameCount);
-	statusArray.push_back(json);
+	statusArray.push_back({ std::string(gameId), time(nullptr), playerCount, gameCount });
 }
 
 void statusCommit(std::string_view serverId)
 {
 	if (statusArray.empty())
 		return;
-	std::string jsonstr = statusArray.dump(4);
+	JsonWriter writer(statusJson);
+	writer.beginArray();
+	for (const Status& status : statusArray)
+		writeStatus(writer, status);
+	writer.endArray();
 	if (!statusUrl.empty()) {
-		Http().post(statusUrl + '/' + std::string(serverId), jsonstr, "application/json");
+		std::string url = statusUrl + '/' + std::string(serverId);
+		retryRequest(url, retryPolicy, [&url]() {
+			Http(httpOptions).post(url, statusJson, "application/json");
+		});
 	}
 	else
 	{
@@ -101,7 +136,7 @@ void statusCommit(std::string_view serverId)
 			perror(path.c_str());
 			return;
 		}
-		fwrite(jsonstr.c_str(), 1, jsonstr.length(), f);
+		fwrite(statusJson.c_str(), 1, statusJson.length(), f);
 		fclose(f);
 	}
 	statusArray.clear();
@@ -110,7 +145,13 @@ void statusCommit(std::string_view serverId)
 extern "C"
 {
 
-int statusGetInterval() {
+int statusGetInterval()
+{
+	try {
+		init();
+	} catch (const std::exception& e) {
+		fprintf(stderr, "statusGetInterval: %s\n", e.what());
+	}
 	return updateInterval;
 }
 
@@ -0,0 +1,234 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "template.h"
+#include "internal.h"
+#include "strprintf.hpp"
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+
+// max length of a formatted int64_t
+static constexpr size_t MAX_INT_LENGTH = 20;
+
+MessageTemplate::MessageTemplate(std::string_view source)
+{
+	size_t pos = 0;
+	auto addSegment = [this](Type type, size_t offset) {
+		if (type == Type::Literal && offset == strings.length())
+			return;
+		segments.push_back(Segment{ type, (uint32_t)offset, (uint32_t)(strings.length() - offset) });
+	};
+	size_t literal = 0;
+	while (pos < source.length())
+	{
+		char c = source[pos++];
+		if (c == '\\' && pos < source.length())
+		{
+			c = source[pos++];
+			strings += c == 'n' ? '\n' : c;
+		}
+		else if (c == '}')
+		{
+			if (pos < source.length() && source[pos] == '}')
+				pos++;
+			strings += '}';
+		}
+		else if (c == '{' && pos < source.length() && source[pos] == '{')
+		{
+			pos++;
+			strings += '{';
+		}
+		else if (c == '{')
+		{
+			size_t end = source.find('}', pos);
+			if (end == std::string_view::npos)
+				throw std::runtime_error("unterminated placeholder");
+			std::string_view name = source.substr(pos, end - pos);
+			pos = end + 1;
+			Type type = Type::Text;
+			size_t colon = name.find(':');
+			if (colon != std::string_view::npos)
+			{
+				std::string_view typeName = name.substr(colon + 1);
+				if (typeName == "raw")
+					type = Type::Raw;
+				else if (typeName == "int")
+					type = Type::Int;
+				else
+					throw std::runtime_error(strprintf("unknown placeholder type: %.*s", (int)typeName.length(), typeName.data()));
+				name = name.substr(0, colon);
+			}
+			if (name.empty())
+				throw std::runtime_error("empty placeholder name");
+			addSegment(Type::Literal, literal);
+			size_t offset = strings.length();
+			strings += name;
+			addSegment(type, offset);
+			literal = strings.length();
+		}
+		else
+		{
+			strings += c;
+		}
+	}
+	addSegment(Type::Literal, literal);
+}
+
+static const TemplateArg *findArg(std::string_view name, const TemplateArg *args, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		if (args[i].name == name)
+			return &args[i];
+	return nullptr;
+}
+
+static void appendInt(std::string& out, int64_t v)
+{
+	char buf[MAX_INT_LENGTH + 1];
+	auto res = std::to_chars(buf, buf + sizeof(buf), v);
+	out.append(buf, res.ptr - buf);
+}
+
+void MessageTemplate::render(std::string& out, const TemplateArg *args, size_t count) const
+{
+	// compute an upper bound of the length so that the buffer is allocated once
+	size_t length = 0;
+	for (const Segment& segment : segments)
+	{
+		const TemplateArg *arg = segment.type == Type::Literal ? nullptr : findArg(str(segment), args, count);
+		if (segment.type == Type::Literal)
+			length += segment.length;
+		else if (arg == nullptr)
+			continue;
+		else if (arg->isNumber || segment.type == Type::Int)
+			length += MAX_INT_LENGTH;
+		else if (segment.type == Type::Raw)
+			length += arg->value.length();
+		else
+			length += arg->value.length() * 2;
+	}
+	out.clear();
+	out.reserve(length);
+	for (const Segment& segment : segments)
+	{
+		if (segment.type == Type::Literal) {
+			out += str(segment);
+			continue;
+		}
+		const TemplateArg *arg = findArg(str(segment), args, count);
+		if (arg == nullptr)
+			continue;
+		if (arg->isNumber)
+			appendInt(out, arg->number);
+		else if (segment.type == Type::Int)
+			appendInt(out, strtoll(std::string(arg->value).c_str(), nullptr, 10));
+		else if (segment.type == Type::Raw)
+			out += arg->value;
+		else
+			appendEscaped(out, arg->value);
+	}
+}
+
+void TemplateSet::load(std::istream& stream)
+{
+	std::string line;
+	int lineNum = 0;
+	while (std::getline(stream, line))
+	{
+		lineNum++;
+		std::string_view sv(line);
+		while (!sv.empty() && std::isspace((uint8_t)sv.front()))
+			sv.remove_prefix(1);
+		while (!sv.empty() && std::isspace((uint8_t)sv.back()))
+			sv.remove_suffix(1);
+		if (sv.empty() || sv[0] == '#' || sv[0] == ';')
+			continue;
+		size_t equal = sv.find('=');
+		if (equal == std::string_view::npos) {
+			fprintf(stderr, "Templates line %d: missing '='\n", lineNum);
+			continue;
+		}
+		std::string_view key = sv.substr(0, equal);
+		while (!key.empty() && std::isspace((uint8_t)key.back()))
+			key.remove_suffix(1);
+		std::string_view value = sv.substr(equal + 1);
+		while (!value.empty() && std::isspace((uint8_t)value.front()))
+			value.remove_prefix(1);
+
+		// [gameId.]template.field
+		size_t dot = key.rfind('.');
+		if (dot == std::string_view::npos || dot == 0) {
+			fprintf(stderr, "Templates line %d: invalid key\n", lineNum);
+			continue;
+		}
+		std::string_view field = key.substr(dot + 1);
+		key = key.substr(0, dot);
+		std::string_view gameId;
+		dot = key.rfind('.');
+		if (dot != std::string_view::npos) {
+			gameId = key.substr(0, dot);
+			key = key.substr(dot + 1);
+		}
+		MessageTemplate Entry::*member;
+		if (field == "content")
+			member = &Entry::content;
+		else if (field == "title")
+			member = &Entry::title;
+		else if (field == "text")
+			member = &Entry::text;
+		else {
+			fprintf(stderr, "Templates line %d: unknown field %.*s\n", lineNum, (int)field.length(), field.data());
+			continue;
+		}
+		try {
+			MessageTemplate tmpl(value);
+			// only registered once it parses
+			games[std::string(gameId)][std::string(key)].*member = std::move(tmpl);
+		} catch (const std::runtime_error& e) {
+			fprintf(stderr, "Templates line %d: %s\n", lineNum, e.what());
+		}
+	}
+}
+
+const TemplateSet::Entry *TemplateSet::find(std::string_view gameId, std::string_view name) const
+{
+	for (std::string_view id : { gameId, std::string_view() })
+	{
+		auto game = games.find(id);
+		if (game == games.end())
+			continue;
+		auto it = game->second.find(name);
+		if (it != game->second.end())
+			return &it->second;
+	}
+	return nullptr;
+}
+
+bool TemplateSet::render(std::string_view gameId, std::string_view name, const TemplateArg *args, size_t count,
+		Notif& notif) const
+{
+	const Entry *entry = find(gameId, name);
+	if (entry == nullptr)
+		return false;
+	entry->content.render(notif.content, args, count);
+	entry->title.render(notif.embed.title, args, count);
+	entry->text.render(notif.embed.text, args, count);
+	return true;
+}
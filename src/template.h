@@ -0,0 +1,96 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "discord.hpp"
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// Message template parsed once into a list of literal and placeholder segments.
+// Placeholders are {name}, {name:raw} and {name:int}. Argument values are escaped
+// unless the placeholder is raw, and formatted as integers if it's int.
+// In literal text, {{ and }} stand for braces, \n for a new line and \\ for a backslash.
+//
+class MessageTemplate
+{
+public:
+	// Throws std::runtime_error if the template is invalid
+	explicit MessageTemplate(std::string_view source = {});
+
+	// Replaces the content of out with the rendered template.
+	// out is only reallocated if its capacity is too small.
+	// Missing arguments are rendered as empty strings.
+	void render(std::string& out, const TemplateArg *args, size_t count) const;
+	bool empty() const {
+		return segments.empty();
+	}
+
+private:
+	enum class Type : uint8_t {
+		Literal,
+		Text,
+		Raw,
+		Int,
+	};
+	struct Segment
+	{
+		Type type;
+		// literal text or placeholder name in strings
+		uint32_t offset;
+		uint32_t length;
+	};
+	std::string_view str(const Segment& segment) const {
+		return std::string_view(strings).substr(segment.offset, segment.length);
+	}
+
+	std::string strings;
+	std::vector<Segment> segments;
+};
+
+//
+// Notification templates of all games.
+// Each line of the template file is "[gameId.]template.field = text" where field is content, title or text.
+// Templates without a game id are used for games without their own.
+//
+class TemplateSet
+{
+public:
+	struct Entry
+	{
+		MessageTemplate content;
+		MessageTemplate title;
+		MessageTemplate text;
+	};
+
+	// Invalid lines are reported and ignored
+	void load(std::istream& stream);
+	const Entry *find(std::string_view gameId, std::string_view name) const;
+	// Returns false if the template doesn't exist
+	bool render(std::string_view gameId, std::string_view name, const TemplateArg *args, size_t count,
+			Notif& notif) const;
+
+private:
+	using Templates = std::map<std::string, Entry, std::less<>>;
+	// indexed by game id, the empty string for templates shared by all games
+	std::map<std::string, Templates, std::less<>> games;
+};
@@ -0,0 +1,173 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "wordfilter.h"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+
+static uint8_t fold(uint8_t c) {
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+WordFilter::WordFilter(const std::vector<std::string>& words)
+{
+	// Bytes that don't appear in any word share class 0, which always leads back to the root
+	for (const std::string& word : words)
+		for (char c : word)
+		{
+			uint8_t b = fold(c);
+			if (classes[b] == 0)
+				classes[b] = classCount++;
+		}
+	for (int c = 'A'; c <= 'Z'; c++)
+		classes[c] = classes[fold(c)];
+
+	// Build the trie. The root is state 0, which can't be the target of a trie edge,
+	// so 0 also means no transition.
+	transitions.assign(classCount, 0);
+	matchLength.assign(1, 0);
+	for (const std::string& word : words)
+	{
+		if (word.empty())
+			continue;
+		uint32_t state = 0;
+		for (char c : word)
+		{
+			uint32_t& target = transitions[state * classCount + classes[(uint8_t)c]];
+			if (target == 0)
+			{
+				target = stateCount++;
+				transitions.resize(stateCount * classCount, 0);
+				matchLength.push_back(0);
+			}
+			// the vector may have been reallocated
+			state = transitions[state * classCount + classes[(uint8_t)c]];
+		}
+		matchLength[state] = (uint16_t)std::min<size_t>(word.length(), UINT16_MAX);
+	}
+
+	// Turn it into a complete automaton, breadth first so that the failure state
+	// of each state is complete before it's used.
+	std::vector<uint32_t> failure(stateCount, 0);
+	std::deque<uint32_t> queue;
+	for (uint32_t c = 1; c < classCount; c++)
+		if (transitions[c] != 0)
+			queue.push_back(transitions[c]);
+	while (!queue.empty())
+	{
+		uint32_t state = queue.front();
+		queue.pop_front();
+		uint32_t fail = failure[state];
+		matchLength[state] = std::max(matchLength[state], matchLength[fail]);
+		for (uint32_t c = 1; c < classCount; c++)
+		{
+			uint32_t& target = transitions[state * classCount + c];
+			uint32_t failTarget = transitions[fail * classCount + c];
+			if (target == 0) {
+				target = failTarget;
+			}
+			else {
+				failure[target] = failTarget;
+				queue.push_back(target);
+			}
+		}
+	}
+}
+
+WordFilter WordFilter::load(std::istream& stream)
+{
+	std::vector<std::string> words;
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		while (!line.empty() && std::isspace((uint8_t)line.back()))
+			line.pop_back();
+		size_t start = 0;
+		while (start < line.length() && std::isspace((uint8_t)line[start]))
+			start++;
+		if (start == line.length() || line[start] == '#')
+			continue;
+		words.push_back(line.substr(start));
+	}
+	return WordFilter(words);
+}
+
+bool WordFilter::mask(std::string_view str, std::string& out) const
+{
+	if (empty())
+		return false;
+	uint32_t state = 0;
+	// end of the masked part of the output
+	size_t masked = 0;
+	bool found = false;
+	for (size_t i = 0; i < str.length(); i++)
+	{
+		state = next(state, str[i]);
+		unsigned length = matchLength[state];
+		if (length == 0)
+			continue;
+		if (!found) {
+			out = str;
+			found = true;
+		}
+		for (size_t j = std::max(i + 1 - length, masked); j <= i; j++)
+			out[j] = '*';
+		masked = i + 1;
+	}
+	return found;
+}
+
+bool WordFilter::maskEscaped(std::string_view str, std::string& out) const
+{
+	if (empty())
+		return false;
+	// offset in str of each character, with its escaping backslash if any
+	thread_local std::vector<size_t> starts;
+	thread_local std::vector<bool> masked;
+	starts.clear();
+	masked.clear();
+	uint32_t state = 0;
+	bool found = false;
+	for (size_t i = 0; i < str.length(); i++)
+	{
+		starts.push_back(i);
+		masked.push_back(false);
+		if (str[i] == '\\' && i + 1 < str.length() && std::ispunct((uint8_t)str[i + 1]))
+			i++;
+		state = next(state, str[i]);
+		unsigned length = matchLength[state];
+		if (length == 0)
+			continue;
+		found = true;
+		std::fill(masked.end() - std::min<size_t>(length, masked.size()), masked.end(), true);
+	}
+	if (!found)
+		return false;
+	out.clear();
+	for (size_t i = 0; i < starts.size(); i++)
+	{
+		if (masked[i]) {
+			out += "\\*";
+		}
+		else {
+			size_t end = i + 1 < starts.size() ? starts[i + 1] : str.length();
+			out.append(str, starts[i], end - starts[i]);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// Masks banned words in chat messages.
+// The words are compiled into an Aho-Corasick automaton whose transitions are stored in
+// a flat table indexed by state and byte class, so that a message is scanned in linear time
+// with one table lookup per byte. Matching is case-insensitive for ASCII letters and
+// doesn't care about word boundaries.
+//
+class WordFilter
+{
+public:
+	WordFilter() = default;
+	explicit WordFilter(const std::vector<std::string>& words);
+
+	// Reads one word per line. Empty lines and lines starting with # are ignored.
+	static WordFilter load(std::istream& stream);
+
+	// Replaces each byte of the banned words found in str by '*' and stores the result in out.
+	// Returns false and leaves out untouched if nothing was found.
+	bool mask(std::string_view str, std::string& out) const;
+	// Same as mask() for Discord markdown text: backslash-escaped characters are matched
+	// as the characters themselves, and each masked character is replaced by an escaped '*'.
+	bool maskEscaped(std::string_view str, std::string& out) const;
+	bool empty() const {
+		return stateCount <= 1;
+	}
+
+private:
+	uint32_t next(uint32_t state, uint8_t c) const {
+		return transitions[state * classCount + classes[c]];
+	}
+
+	uint8_t classes[256] {};
+	uint32_t classCount = 1;
+	uint32_t stateCount = 1;
+	std::vector<uint32_t> transitions;
+	// length of the longest word ending at each state, 0 if none
+	std::vector<uint16_t> matchLength;
+};
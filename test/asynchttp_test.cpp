@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "../include/asynchttp.hpp"
+#include "testserver.h"
+#include <curl/curl.h>
+#include <vector>
+
+class AsyncHttpTest : public ::testing::Test
+{
+protected:
+	void SetUp() override {
+		http = AsyncHttp::create(io);
+	}
+
+	// Runs the io_context until count requests have completed
+	void run(size_t count)
+	{
+		expected = count;
+		io.restart();
+		io.run_for(std::chrono::seconds(10));
+		ASSERT_EQ(count, results.size());
+	}
+
+	AsyncHttp::Handler handler()
+	{
+		return [this](const AsyncHttpResult& result) {
+			results.push_back(result);
+			if (results.size() == expected)
+				io.stop();
+		};
+	}
+
+	asio::io_context io;
+	AsyncHttp::Ptr http;
+	std::vector<AsyncHttpResult> results;
+	size_t expected = 0;
+};
+
+TEST_F(AsyncHttpTest, concurrentPosts)
+{
+	StaticServer server("response body");
+	for (int i = 0; i < 5; i++)
+		http->post(server.url, "{}", "application/json", handler());
+	ASSERT_EQ(5u, http->pending());
+	run(5);
+	for (const AsyncHttpResult& result : results)
+	{
+		ASSERT_TRUE(result.ok());
+		ASSERT_EQ(200, result.status);
+		ASSERT_EQ("response body", result.body);
+	}
+	ASSERT_EQ(0u, http->pending());
+}
+
+TEST_F(AsyncHttpTest, patch)
+{
+	std::string request;
+	TestServer server([&request](const std::string& req) {
+		request = req;
+		return TestServer::response("404 Not Found", "", "");
+	});
+	http->patch(server.url + "messages/1", "{\"content\":\"x\"}", "application/json", handler());
+	run(1);
+	ASSERT_EQ(0, results[0].curlCode);
+	ASSERT_EQ(404, results[0].status);
+	ASSERT_FALSE(results[0].ok());
+	ASSERT_EQ(0u, request.find("PATCH /messages/1 "));
+	ASSERT_NE(std::string::npos, request.find("Content-Type: application/json"));
+	ASSERT_NE(std::string::npos, request.find("{\"content\":\"x\"}"));
+}
+
+TEST_F(AsyncHttpTest, connectionRefused)
+{
+	std::string url;
+	{
+		// nothing listens on this port once the socket is closed
+		TestSocket socket;
+		url = socket.url;
+	}
+	http->post(url, "{}", "application/json", handler());
+	run(1);
+	ASSERT_EQ(CURLE_COULDNT_CONNECT, results[0].curlCode);
+	ASSERT_EQ(0, results[0].status);
+	ASSERT_FALSE(results[0].ok());
+}
+
+TEST_F(AsyncHttpTest, timeout)
+{
+	SilentServer server;
+	http->setTimeouts(std::chrono::milliseconds(0), std::chrono::milliseconds(200));
+	auto start = std::chrono::steady_clock::now();
+	http->post(server.url, "{}", "application/json", handler());
+	run(1);
+	ASSERT_EQ(CURLE_OPERATION_TIMEDOUT, results[0].curlCode);
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
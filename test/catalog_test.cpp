@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+#include "../src/catalog.h"
+#include "testserver.h"
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <unistd.h>
+
+class CatalogTest : public ::testing::Test {
+protected:
+	GameCatalog parse(const std::string& s) {
+		std::stringstream stream(s);
+		return GameCatalog::parse(stream);
+	}
+};
+
+TEST_F(CatalogTest, empty)
+{
+	GameCatalog catalog = parse("{}");
+	ASSERT_EQ(0, catalog.size());
+	ASSERT_EQ(nullptr, catalog.find("chuchu"));
+	ASSERT_EQ(nullptr, catalog.find(""));
+}
+
+TEST_F(CatalogTest, find)
+{
+	GameCatalog catalog = parse(R"({
+		"chuchu": { "name": "ChuChu Rocket!", "thumbnail": "https://chuchu.jpg" },
+		"pso": { "name": "Phantasy Star Online", "thumbnail": "https://pso.jpg" },
+		"broken": { "name": "No thumbnail" }
+	})");
+	ASSERT_EQ(2, catalog.size());
+	const GameInfo *game = catalog.find("chuchu");
+	ASSERT_NE(nullptr, game);
+	ASSERT_EQ("chuchu", game->id);
+	ASSERT_EQ("ChuChu Rocket!", game->name);
+	ASSERT_EQ("https://chuchu.jpg", game->thumbnail);
+	ASSERT_EQ('\0', game->name.data()[game->name.length()]);
+	game = catalog.find(std::string("pso"));
+	ASSERT_NE(nullptr, game);
+	ASSERT_EQ("Phantasy Star Online", game->name);
+	ASSERT_EQ(nullptr, catalog.find("broken"));
+	ASSERT_EQ(nullptr, catalog.find("chu"));
+}
+
+TEST_F(CatalogTest, many)
+{
+	std::string json = "{";
+	for (int i = 0; i < 1000; i++)
+	{
+		if (i != 0)
+			json += ',';
+		json += "\"game" + std::to_string(i) + "\": { \"name\": \"Game " + std::to_string(i)
+				+ "\", \"thumbnail\": \"\" }";
+	}
+	json += "}";
+	GameCatalog catalog = parse(json);
+	ASSERT_EQ(1000, catalog.size());
+	for (int i = 0; i < 1000; i++)
+	{
+		const GameInfo *game = catalog.find("game" + std::to_string(i));
+		ASSERT_NE(nullptr, game);
+		ASSERT_EQ("Game " + std::to_string(i), game->name);
+	}
+	ASSERT_EQ(nullptr, catalog.find("game1000"));
+}
+
+TEST_F(CatalogTest, builtin)
+{
+	const GameInfo *game = findBuiltinGame("chuchu");
+	ASSERT_NE(nullptr, game);
+	ASSERT_EQ("ChuChu Rocket!", game->name);
+	ASSERT_EQ("https://dcnet.flyca.st/gamepic/chuchu.jpg", game->thumbnail);
+	ASSERT_EQ('\0', game->thumbnail.data()[game->thumbnail.length()]);
+	ASSERT_NE(nullptr, findBuiltinGame("toyracer-eu"));
+	ASSERT_EQ(nullptr, findBuiltinGame("nosuchgame"));
+	ASSERT_EQ(nullptr, findBuiltinGame(""));
+}
+
+TEST_F(CatalogTest, remote)
+{
+	unlink("games-cache.json");
+	unlink("games-cache.json.meta");
+	std::atomic_int version { 1 };
+	std::atomic_int requests { 0 };
+	TestServer server([&](const std::string& request) {
+		requests++;
+		std::string etag = "\"v" + std::to_string(version) + "\"";
+		if (request.find("If-None-Match: " + etag) != std::string::npos)
+			return TestServer::response("304 Not Modified", "ETag: " + etag + "\r\n", "");
+		return TestServer::response("200 OK", "ETag: " + etag + "\r\n",
+				R"({ "game)" + std::to_string(version) + R"(": { "name": "Game", "thumbnail": "" } })");
+	});
+	{
+		RemoteCatalog catalog(server.url, "games-cache.json");
+		catalog.loadCache();
+		ASSERT_EQ(nullptr, catalog.get());
+		ASSERT_TRUE(catalog.refresh());
+		const GameInfo *game1 = catalog.get()->find("game1");
+		ASSERT_NE(nullptr, game1);
+		// not modified
+		ASSERT_FALSE(catalog.refresh());
+		ASSERT_EQ(game1, catalog.get()->find("game1"));
+
+		version = 2;
+		ASSERT_TRUE(catalog.refresh());
+		ASSERT_EQ(nullptr, catalog.get()->find("game1"));
+		ASSERT_NE(nullptr, catalog.get()->find("game2"));
+		// previous versions are still valid
+		ASSERT_EQ("game1", game1->id);
+		ASSERT_EQ(3, requests);
+	}
+	// cold start from the cache
+	RemoteCatalog catalog(server.url, "games-cache.json");
+	catalog.loadCache();
+	ASSERT_NE(nullptr, catalog.get());
+	ASSERT_NE(nullptr, catalog.get()->find("game2"));
+	ASSERT_FALSE(catalog.refresh());
+	ASSERT_EQ(4, requests);
+}
+
+TEST_F(CatalogTest, remoteUnavailable)
+{
+	RemoteCatalog catalog("http://127.0.0.1:1/games.json", "");
+	ASSERT_THROW(catalog.refresh(), std::exception);
+	ASSERT_EQ(nullptr, catalog.get());
+
+	TestServer server([](const std::string&) {
+		return TestServer::response("200 OK", "", "not json");
+	});
+	RemoteCatalog invalid(server.url, "");
+	ASSERT_THROW(invalid.refresh(), std::exception);
+	ASSERT_EQ(nullptr, invalid.get());
+}
+
+TEST_F(CatalogTest, remoteUnchanged)
+{
+	// no validators
+	TestServer server([](const std::string&) {
+		return TestServer::response("200 OK", "", R"({ "game1": { "name": "Game", "thumbnail": "" } })");
+	});
+	RemoteCatalog catalog(server.url, "");
+	ASSERT_TRUE(catalog.refresh());
+	const GameCatalog *version = catalog.get();
+	ASSERT_FALSE(catalog.refresh());
+	ASSERT_EQ(version, catalog.get());
+}
+
+TEST_F(CatalogTest, remoteStop)
+{
+	SilentServer server;
+	auto start = std::chrono::steady_clock::now();
+	{
+		RemoteCatalog catalog(server.url, "");
+		catalog.start(std::chrono::seconds(3600));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		// cancels the refresh in progress
+	}
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "../src/debounce.h"
+
+using namespace std::chrono;
+
+class DebounceTest : public ::testing::Test {
+protected:
+	Debouncer::clock::time_point t0 = Debouncer::clock::now();
+
+	static Notif notif(const std::string& title, const std::string& text = "")
+	{
+		Notif n;
+		n.embed.title = title;
+		n.embed.text = text;
+		return n;
+	}
+};
+
+TEST_F(DebounceTest, suppress)
+{
+	Debouncer debouncer(seconds(10), Debouncer::Mode::Suppress);
+	ASSERT_TRUE(debouncer.admit("game", notif("Player joined"), t0));
+	ASSERT_FALSE(debouncer.admit("game", notif("Player joined", "other text"), t0 + seconds(1)));
+	// different title or game
+	ASSERT_TRUE(debouncer.admit("game", notif("Player left"), t0 + seconds(1)));
+	ASSERT_TRUE(debouncer.admit("other", notif("Player joined"), t0 + seconds(1)));
+	// still in the previous bucket
+	ASSERT_FALSE(debouncer.admit("game", notif("Player joined"), t0 + seconds(15)));
+	// expired
+	ASSERT_TRUE(debouncer.admit("game", notif("Player joined"), t0 + seconds(20)));
+	ASSERT_TRUE(debouncer.expired(t0 + seconds(100)).empty());
+	ASSERT_EQ(Debouncer::clock::time_point::max(), debouncer.nextExpiry());
+}
+
+TEST_F(DebounceTest, fold)
+{
+	Debouncer debouncer(seconds(10), Debouncer::Mode::Fold);
+	ASSERT_EQ(Debouncer::clock::time_point::max(), debouncer.nextExpiry());
+	ASSERT_TRUE(debouncer.admit("game", notif("Player joined", "1"), t0));
+	ASSERT_EQ(Debouncer::clock::time_point::max(), debouncer.nextExpiry());
+	ASSERT_FALSE(debouncer.admit("game", notif("Player joined", "2"), t0 + seconds(1)));
+	ASSERT_FALSE(debouncer.admit("game", notif("Player joined", "3"), t0 + seconds(2)));
+	ASSERT_EQ(t0 + seconds(20), debouncer.nextExpiry());
+	ASSERT_TRUE(debouncer.expired(t0 + seconds(10)).empty());
+	ASSERT_EQ(t0 + seconds(20), debouncer.nextExpiry());
+
+	auto summaries = debouncer.expired(t0 + seconds(20));
+	ASSERT_EQ(1u, summaries.size());
+	ASSERT_EQ("game", summaries[0].gameId);
+	ASSERT_EQ("Player joined ×2", summaries[0].notif.embed.title);
+	ASSERT_EQ("3", summaries[0].notif.embed.text);
+	ASSERT_EQ(Debouncer::clock::time_point::max(), debouncer.nextExpiry());
+	ASSERT_TRUE(debouncer.admit("game", notif("Player joined"), t0 + seconds(20)));
+}
+
+TEST_F(DebounceTest, foldOnAdmit)
+{
+	Debouncer debouncer(seconds(10), Debouncer::Mode::Fold);
+	ASSERT_TRUE(debouncer.admit("game", notif("Player joined"), t0));
+	ASSERT_FALSE(debouncer.admit("game", notif("Player joined"), t0 + seconds(1)));
+	// both buckets expire
+	ASSERT_TRUE(debouncer.admit("game", notif("Player left"), t0 + seconds(60)));
+	ASSERT_EQ(Debouncer::clock::time_point::min(), debouncer.nextExpiry());
+	auto summaries = debouncer.expired(t0 + seconds(60));
+	ASSERT_EQ(1u, summaries.size());
+	ASSERT_EQ("Player joined ×1", summaries[0].notif.embed.title);
+	ASSERT_EQ(Debouncer::clock::time_point::max(), debouncer.nextExpiry());
+}
@@ -1,7 +1,9 @@
 #include "gtest/gtest.h"
 #include "../include/discord.hpp"
+#include <random>
 
 void discordForceWebhook(std::string_view url);
+extern "C" size_t discordEscapeInto(const char *s, char *buf, size_t bufsize);
 
 class DiscordTest : public ::testing::Test {
 protected:
@@ -16,6 +18,57 @@ TEST_F(DiscordTest, escape)
 	ASSERT_EQ("+\\*a\\>b\\_c\\:d", discordEscape("+*a>b_c:d"));
 }
 
+static std::string naiveEscape(std::string_view s)
+{
+	std::string ret;
+	for (char c : s)
+	{
+		if (std::string_view("*_`~<>:[\\").find(c) != std::string_view::npos)
+			ret += '\\';
+		ret += c;
+	}
+	return ret;
+}
+
+TEST_F(DiscordTest, escapeLong)
+{
+	std::mt19937 rng(42);
+	const std::string_view alphabet = "abc*_`~<>:[\\ \xc3\xa9";
+	// cover the vector loops, their tails and specials at block boundaries
+	for (size_t len = 0; len < 200; len++)
+	{
+		std::string s;
+		for (size_t i = 0; i < len; i++)
+			s += alphabet[rng() % alphabet.size()];
+		ASSERT_EQ(naiveEscape(s), discordEscape(s)) << "length " << len;
+	}
+	for (size_t pos : { 15, 16, 31, 32, 33, 63, 64 })
+	{
+		std::string s(65, 'x');
+		s[pos] = '~';
+		ASSERT_EQ(naiveEscape(s), discordEscape(s)) << "position " << pos;
+	}
+}
+
+TEST_F(DiscordTest, escapeInto)
+{
+	char buf[16];
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", buf, sizeof(buf)));
+	ASSERT_STREQ("a\\*b\\_c", buf);
+	// an escape sequence is never split
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", buf, 4));
+	ASSERT_STREQ("a\\*", buf);
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", buf, 2));
+	ASSERT_STREQ("a", buf);
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", buf, 5));
+	ASSERT_STREQ("a\\*b", buf);
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", buf, 1));
+	ASSERT_STREQ("", buf);
+	ASSERT_EQ(7u, discordEscapeInto("a*b_c", nullptr, 0));
+	ASSERT_EQ(0u, discordEscapeInto("", buf, sizeof(buf)));
+	ASSERT_STREQ("", buf);
+}
+
 TEST_F(DiscordTest, notification)
 {
 	const char *webhook = getenv("DISCORD_WEBHOOK");
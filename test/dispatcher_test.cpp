@@ -0,0 +1,320 @@
+#include "gtest/gtest.h"
+#include "../src/dispatcher.h"
+#include <thread>
+#include <vector>
+
+class DispatcherTest : public ::testing::Test {
+protected:
+	static PendingNotif make(int i) {
+		PendingNotif p;
+		p.gameId = std::to_string(i);
+		return p;
+	}
+	static DispatcherOptions options(unsigned threads, size_t queueSize, OverflowPolicy overflow,
+			size_t batchSize = 1, int batchWindow = 0)
+	{
+		DispatcherOptions options;
+		options.threads = threads;
+		options.queueSize = queueSize;
+		options.overflow = overflow;
+		options.batchSize = batchSize;
+		options.batchWindow = std::chrono::milliseconds(batchWindow);
+		return options;
+	}
+};
+
+TEST_F(DispatcherTest, queue)
+{
+	BoundedQueue<int> queue(5);
+	ASSERT_EQ(8, queue.capacity());
+	ASSERT_TRUE(queue.empty());
+	for (int i = 0; i < 8; i++)
+		ASSERT_TRUE(queue.tryPush(std::move(i)));
+	int v = 42;
+	ASSERT_FALSE(queue.tryPush(std::move(v)));
+	ASSERT_EQ(8, queue.size());
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(queue.tryPop(v));
+		ASSERT_EQ(i, v);
+	}
+	ASSERT_FALSE(queue.tryPop(v));
+}
+
+TEST_F(DispatcherTest, queueConcurrent)
+{
+	BoundedQueue<int> queue(64);
+	constexpr int Producers = 4;
+	constexpr int Count = 5000;
+	std::atomic_int64_t sum { 0 };
+	std::atomic_int popped { 0 };
+	std::vector<std::thread> threads;
+	for (int p = 0; p < Producers; p++)
+		threads.emplace_back([&queue]() {
+			for (int i = 1; i <= Count; i++) {
+				int v = i;
+				while (!queue.tryPush(std::move(v)))
+					std::this_thread::yield();
+			}
+		});
+	for (int c = 0; c < 2; c++)
+		threads.emplace_back([&]() {
+			while (popped.load() < Producers * Count)
+			{
+				int v;
+				if (queue.tryPop(v)) {
+					sum += v;
+					popped++;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	ASSERT_EQ((int64_t)Producers * Count * (Count + 1) / 2, sum.load());
+}
+
+TEST_F(DispatcherTest, overflowPolicy)
+{
+	ASSERT_EQ(OverflowPolicy::Block, parseOverflowPolicy("block"));
+	ASSERT_EQ(OverflowPolicy::DropOldest, parseOverflowPolicy("drop-oldest"));
+	ASSERT_EQ(OverflowPolicy::DropNewest, parseOverflowPolicy("drop-newest"));
+}
+
+TEST_F(DispatcherTest, dispatch)
+{
+	std::atomic_int count { 0 };
+	{
+		Dispatcher dispatcher(options(3, 16, OverflowPolicy::Block), { "route" }, [&count](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+			count += batch.size();
+		});
+		for (int i = 0; i < 1000; i++)
+			ASSERT_TRUE(dispatcher.enqueue(0, make(i)));
+	}
+	ASSERT_EQ(1000, count.load());
+}
+
+TEST_F(DispatcherTest, dropNewest)
+{
+	std::mutex mutex;
+	mutex.lock();
+	std::vector<std::string> handled;
+	{
+		Dispatcher dispatcher(options(1, 2, OverflowPolicy::DropNewest), { "route" }, [&](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+			std::lock_guard<std::mutex> _(mutex);
+			for (const auto& p : batch)
+				handled.push_back(p.gameId);
+		});
+		ASSERT_TRUE(dispatcher.enqueue(0, make(0)));
+		while (dispatcher.droppedCount(0) == 0)
+			dispatcher.enqueue(0, make(1));
+		mutex.unlock();
+	}
+	// the worker may or may not have picked up the first one before the queue filled up
+	ASSERT_LE(2, handled.size());
+	ASSERT_GE(3, handled.size());
+	ASSERT_EQ("0", handled[0]);
+}
+
+TEST_F(DispatcherTest, dropOldest)
+{
+	std::mutex mutex;
+	mutex.lock();
+	std::vector<std::string> handled;
+	{
+		Dispatcher dispatcher(options(1, 2, OverflowPolicy::DropOldest), { "route" }, [&](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+			std::lock_guard<std::mutex> _(mutex);
+			for (const auto& p : batch)
+				handled.push_back(p.gameId);
+		});
+		for (int i = 0; i < 100; i++)
+			ASSERT_TRUE(dispatcher.enqueue(0, make(i)));
+		ASSERT_LE(97, dispatcher.droppedCount(0));
+		mutex.unlock();
+	}
+	ASSERT_GE(3, handled.size());
+	ASSERT_EQ("99", handled.back());
+}
+
+TEST_F(DispatcherTest, batch)
+{
+	std::mutex mutex;
+	std::vector<size_t> batchSizes;
+	{
+		Dispatcher dispatcher(options(2, 64, OverflowPolicy::Block, 10, 200), { "route" }, [&](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+			std::lock_guard<std::mutex> _(mutex);
+			batchSizes.push_back(batch.size());
+		});
+		for (int i = 0; i < 25; i++)
+			ASSERT_TRUE(dispatcher.enqueue(0, make(i)));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	ASSERT_EQ(3, batchSizes.size());
+	ASSERT_EQ(10, batchSizes[0]);
+	ASSERT_EQ(10, batchSizes[1]);
+	ASSERT_EQ(5, batchSizes[2]);
+}
+
+TEST_F(DispatcherTest, batchWindow)
+{
+	std::atomic_int batches { 0 };
+	std::atomic_int count { 0 };
+	Dispatcher dispatcher(options(1, 64, OverflowPolicy::Block, 10, 100), { "route" }, [&](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+		count += batch.size();
+		batches++;
+	});
+	ASSERT_TRUE(dispatcher.enqueue(0, make(0)));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_TRUE(dispatcher.enqueue(0, make(1)));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(0, batches.load());
+	// the window has elapsed
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	ASSERT_EQ(1, batches.load());
+	ASSERT_EQ(2, count.load());
+}
+
+TEST_F(DispatcherTest, routes)
+{
+	std::mutex mutex;
+	mutex.lock();
+	std::atomic_int fast { 0 };
+	{
+		Dispatcher dispatcher(options(2, 16, OverflowPolicy::Block), { "slow", "fast" },
+			[&](Dispatcher::Route& route, std::vector<PendingNotif>& batch) {
+				if (route.url == "slow") {
+					std::lock_guard<std::mutex> _(mutex);
+				}
+				else {
+					fast += batch.size();
+				}
+			});
+		ASSERT_EQ(2, dispatcher.routeCount());
+		// a stuck route doesn't prevent delivery to other routes
+		for (int i = 0; i < 10; i++)
+			ASSERT_TRUE(dispatcher.enqueue(0, make(i)));
+		for (int i = 0; i < 100; i++)
+			ASSERT_TRUE(dispatcher.enqueue(1, make(i)));
+		for (int i = 0; i < 100 && fast.load() < 100; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		ASSERT_EQ(100, fast.load());
+		mutex.unlock();
+	}
+}
+
+TEST_F(DispatcherTest, idleTask)
+{
+	std::atomic_int runs { 0 };
+	Dispatcher dispatcher(options(2, 16, OverflowPolicy::Block), { "route" },
+		[](Dispatcher::Route&, std::vector<PendingNotif>&) {},
+		[&runs](Dispatcher::clock::time_point) {
+			runs++;
+			return Dispatcher::clock::time_point::max();
+		});
+	// runs once at startup
+	for (int i = 0; i < 100 && runs.load() == 0; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(1, runs.load());
+	dispatcher.scheduleIdleTask(Dispatcher::clock::now() + std::chrono::milliseconds(20));
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(1, runs.load());
+	for (int i = 0; i < 100 && runs.load() == 1; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(2, runs.load());
+	ASSERT_NE(nullptr, dispatcher.findRoute("route"));
+	ASSERT_EQ(nullptr, dispatcher.findRoute("other"));
+}
+
+TEST_F(DispatcherTest, priority)
+{
+	std::mutex mutex;
+	mutex.lock();
+	std::vector<std::string> handled;
+	{
+		Dispatcher dispatcher(options(1, 4, OverflowPolicy::DropNewest), { "route" }, [&](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+			std::lock_guard<std::mutex> _(mutex);
+			for (const auto& p : batch)
+				handled.push_back(p.gameId);
+		});
+		// the worker is stuck on this one
+		ASSERT_TRUE(dispatcher.enqueue(0, make(0)));
+		while (dispatcher.classStats(0, NotifPriority::Normal).sent == 0)
+			std::this_thread::yield();
+		for (int i = 1; i <= 4; i++)
+		{
+			PendingNotif p = make(i);
+			p.notif.priority = NotifPriority::Low;
+			ASSERT_TRUE(dispatcher.enqueue(0, std::move(p)));
+		}
+		// full: low priority notifications make room for the others
+		ASSERT_TRUE(dispatcher.enqueue(0, make(5)));
+		PendingNotif high = make(6);
+		high.notif.priority = NotifPriority::High;
+		ASSERT_TRUE(dispatcher.enqueue(0, std::move(high)));
+		// the queue is full of normal and high priority notifications
+		PendingNotif low = make(7);
+		low.notif.priority = NotifPriority::Low;
+		ASSERT_FALSE(dispatcher.enqueue(0, std::move(low)));
+
+		Dispatcher::ClassStats stats = dispatcher.classStats(0, NotifPriority::Low);
+		ASSERT_EQ(5u, stats.enqueued);
+		ASSERT_EQ(0u, stats.sent);
+		ASSERT_EQ(3u, stats.dropped);
+		ASSERT_EQ(3u, dispatcher.droppedCount(0));
+		mutex.unlock();
+	}
+	// highest priority first, then oldest first
+	std::vector<std::string> expected { "0", "6", "5", "3", "4" };
+	ASSERT_EQ(expected, handled);
+}
+
+TEST_F(DispatcherTest, routeClaim)
+{
+	std::atomic_int count { 0 };
+	Dispatcher dispatcher(options(2, 16, OverflowPolicy::DropOldest), { "route" }, [&count](Dispatcher::Route&, std::vector<PendingNotif>& batch) {
+		count += batch.size();
+	});
+	{
+		Dispatcher::RouteClaim claim(dispatcher, dispatcher.getRoute(0));
+		ASSERT_TRUE(claim);
+		ASSERT_FALSE(Dispatcher::RouteClaim(dispatcher, dispatcher.getRoute(0)));
+		ASSERT_TRUE(dispatcher.enqueue(0, make(1)));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		// the workers stay away while it's claimed
+		ASSERT_EQ(0, count.load());
+	}
+	for (int i = 0; i < 100 && count == 0; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_EQ(1, count.load());
+}
+
+TEST_F(DispatcherTest, drainTimeout)
+{
+	CancelToken token;
+	DispatcherOptions opts = options(1, 16, OverflowPolicy::DropOldest);
+	opts.drainTimeout = std::chrono::milliseconds(200);
+	opts.cancelToken = &token;
+	std::atomic_int handled { 0 };
+	std::atomic_int cancelled { 0 };
+	auto start = std::chrono::steady_clock::now();
+	{
+		Dispatcher dispatcher(opts, { "a", "b" },
+			[&](Dispatcher::Route& route, std::vector<PendingNotif>& batch) {
+				handled++;
+				if (!token.sleepFor(std::chrono::seconds(60)))
+					cancelled++;
+			});
+		// rate limited for a minute
+		dispatcher.getRoute(1).rateLimiter.block(60);
+		for (int i = 0; i < 3; i++) {
+			ASSERT_TRUE(dispatcher.enqueue(0, make(i)));
+			ASSERT_TRUE(dispatcher.enqueue(1, make(i)));
+		}
+	}
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+	ASSERT_TRUE(token.isCancelled());
+	// rate limits are ignored once expired
+	ASSERT_EQ(6, handled);
+	ASSERT_EQ(6, cancelled);
+}
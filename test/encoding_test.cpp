@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include "../include/encoding.hpp"
+#include "../include/encoding.h"
+
+class EncodingTest : public ::testing::Test {
+};
+
+TEST_F(EncodingTest, parse)
+{
+	ASSERT_EQ(TextEncoding::ShiftJis, parseEncoding("shift-jis"));
+	ASSERT_EQ(TextEncoding::ShiftJis, parseEncoding("cp932"));
+	ASSERT_EQ(TextEncoding::Latin1, parseEncoding("latin1"));
+	ASSERT_EQ(TextEncoding::Utf8, parseEncoding("utf-8"));
+	ASSERT_EQ(TextEncoding::Utf8, parseEncoding("ebcdic"));
+}
+
+TEST_F(EncodingTest, shiftJis)
+{
+	ASSERT_EQ("", toUtf8("", TextEncoding::ShiftJis));
+	ASSERT_EQ("plain ascii text longer than a vector", toUtf8("plain ascii text longer than a vector", TextEncoding::ShiftJis));
+	// こんにちは
+	ASSERT_EQ("\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf",
+			toUtf8("\x82\xb1\x82\xf1\x82\xc9\x82\xbf\x82\xcd", TextEncoding::ShiftJis));
+	// half-width katakana
+	ASSERT_EQ("\xef\xbd\xb6\xef\xbe\x80", toUtf8("\xb6\xc0", TextEncoding::ShiftJis));
+	// trail bytes in the ASCII range: ソフト and 表示
+	ASSERT_EQ("<\xe3\x82\xbd\xe3\x83\x95\xe3\x83\x88>", toUtf8("<\x83\x5c\x83\x74\x83\x67>", TextEncoding::ShiftJis));
+	ASSERT_EQ("\xe8\xa1\xa8\xe7\xa4\xba" "abc", toUtf8("\x95\x5c\x8e\xa6" "abc", TextEncoding::ShiftJis));
+	// NEC special characters: ①
+	ASSERT_EQ("\xe2\x91\xa0", toUtf8("\x87\x40", TextEncoding::ShiftJis));
+	// truncated and invalid sequences
+	ASSERT_EQ("a\xef\xbf\xbd", toUtf8("a\x82", TextEncoding::ShiftJis));
+	ASSERT_EQ("\xef\xbf\xbd a", toUtf8("\x82 a", TextEncoding::ShiftJis));
+	ASSERT_EQ("\xef\xbf\xbd", toUtf8("\xa0", TextEncoding::ShiftJis));
+	ASSERT_EQ("\xef\xbf\xbd", toUtf8("\x85\x40", TextEncoding::ShiftJis));
+}
+
+TEST_F(EncodingTest, latin1)
+{
+	ASSERT_EQ("caf\xc3\xa9 \xc2\xa9", toUtf8("caf\xe9 \xa9", TextEncoding::Latin1));
+	ASSERT_EQ("caf\xc3\xa9", toUtf8("caf\xc3\xa9", TextEncoding::Utf8));
+}
+
+TEST_F(EncodingTest, cApi)
+{
+	char buf[16];
+	// 表示
+	ASSERT_EQ(6u, transcodeToUtf8(DC_ENCODING_SHIFT_JIS, "\x95\x5c\x8e\xa6", buf, sizeof(buf)));
+	ASSERT_STREQ("\xe8\xa1\xa8\xe7\xa4\xba", buf);
+	// no partial sequence
+	ASSERT_EQ(6u, transcodeToUtf8(DC_ENCODING_SHIFT_JIS, "\x95\x5c\x8e\xa6", buf, 6));
+	ASSERT_STREQ("\xe8\xa1\xa8", buf);
+	ASSERT_EQ(6u, transcodeToUtf8(DC_ENCODING_SHIFT_JIS, "\x95\x5c\x8e\xa6", nullptr, 0));
+	ASSERT_EQ(3u, transcodeToUtf8(DC_ENCODING_LATIN1, "\xe9" "a", buf, sizeof(buf)));
+	ASSERT_STREQ("\xc3\xa9" "a", buf);
+}
@@ -0,0 +1,169 @@
+#include "gtest/gtest.h"
+#include "../src/internal.h"
+#include "testserver.h"
+#include <thread>
+#include <zlib.h>
+
+TEST(HttpTest, options)
+{
+	Config config;
+	HttpOptions options;
+	options.load(config);
+	ASSERT_EQ(10000, options.connectTimeout.count());
+	ASSERT_EQ(30000, options.timeout.count());
+	config["connect-timeout"] = { "500" };
+	config["request-timeout"] = { "2000" };
+	options.load(config);
+	ASSERT_EQ(500, options.connectTimeout.count());
+	ASSERT_EQ(2000, options.timeout.count());
+}
+
+TEST(HttpTest, timeout)
+{
+	SilentServer server;
+	HttpOptions options;
+	options.timeout = std::chrono::milliseconds(200);
+	uint64_t timeouts = Http::getStats().timeouts;
+	auto start = std::chrono::steady_clock::now();
+	try {
+		Http(options).post(server.url, "{}", "application/json");
+		FAIL();
+	} catch (const CurlError& e) {
+		ASSERT_TRUE(e.timedOut());
+	}
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+	ASSERT_EQ(timeouts + 1, Http::getStats().timeouts);
+}
+
+TEST(HttpTest, cancel)
+{
+	SilentServer server;
+	CancelToken token;
+	HttpOptions options;
+	options.timeout = std::chrono::milliseconds(0);
+	options.cancelToken = &token;
+	uint64_t cancelled = Http::getStats().cancelled;
+	std::thread canceller([&token]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		token.cancel();
+	});
+	try {
+		Http(options).post(server.url, "{}", "application/json");
+		FAIL();
+	} catch (const CurlError& e) {
+		ASSERT_TRUE(e.cancelled());
+	}
+	canceller.join();
+	ASSERT_EQ(cancelled + 1, Http::getStats().cancelled);
+
+	// already cancelled
+	ASSERT_THROW(Http(options).post(server.url, "{}", "application/json"), CurlError);
+	ASSERT_EQ(cancelled + 2, Http::getStats().cancelled);
+}
+
+TEST(HttpTest, discardResponse)
+{
+	StaticServer server("response body");
+	Http http;
+	testing::internal::CaptureStdout();
+	http.post(server.url, "{}", "application/json");
+	ASSERT_EQ("", testing::internal::GetCapturedStdout());
+	ASSERT_EQ("Value", http.responseHeader("x-test"));
+	ASSERT_EQ("", http.responseHeader("x-missing"));
+}
+
+TEST(HttpTest, captureResponse)
+{
+	StaticServer server("response body");
+	std::string response = "previous";
+	Http().post(server.url, "{}", "application/json", ResponseSink::capture(response));
+	ASSERT_EQ("response body", response);
+	Http().post(server.url, "{}", "application/json", ResponseSink::capture(response, 8));
+	ASSERT_EQ("response", response);
+}
+
+TEST(HttpTest, streamResponse)
+{
+	StaticServer server("response body");
+	std::string response;
+	Http().post(server.url, "{}", "application/json", ResponseSink::stream([&response](std::string_view chunk) {
+		response += chunk;
+		return true;
+	}));
+	ASSERT_EQ("response body", response);
+	ASSERT_THROW(Http().post(server.url, "{}", "application/json", ResponseSink::stream([](std::string_view) {
+		return false;
+	})), CurlError);
+}
+
+TEST(HttpTest, unixSocket)
+{
+	std::string request;
+	TestServer server([&request](const std::string& req) {
+		request = req;
+		return TestServer::response("200 OK", "", "unix");
+	}, "http_test.sock");
+	HttpOptions options;
+	options.unixSocket = "http_test.sock";
+	std::string response;
+	Http(options).post("http://localhost/server1", "[]", "application/json", ResponseSink::capture(response));
+	ASSERT_EQ("unix", response);
+	ASSERT_EQ(0, request.find("POST /server1 HTTP/1.1\r\n"));
+	ASSERT_NE(std::string::npos, request.find("\r\n\r\n[]"));
+	unlink("http_test.sock");
+}
+
+static std::string gunzip(const std::string& data)
+{
+	z_stream stream {};
+	inflateInit2(&stream, 15 + 16);
+	std::string out(64 * 1024, '\0');
+	stream.next_in = (Bytef *)data.data();
+	stream.avail_in = data.size();
+	stream.next_out = (Bytef *)&out[0];
+	stream.avail_out = out.size();
+	int rc = inflate(&stream, Z_FINISH);
+	out.resize(stream.total_out);
+	inflateEnd(&stream);
+	return rc == Z_STREAM_END ? out : "inflate error";
+}
+
+TEST(HttpTest, gzip)
+{
+	std::string request;
+	TestServer server([&request](const std::string& req) {
+		request = req;
+		return TestServer::response("200 OK", "", "");
+	});
+	HttpOptions options;
+	options.gzip = true;
+	options.gzipMinSize = 100;
+	std::string body = "[";
+	for (int i = 0; i < 100; i++)
+		body += "{\"gameId\":\"pso\",\"playerCount\":" + std::to_string(i) + "},";
+	body.back() = ']';
+
+	uint64_t compressed = Http::getStats().compressedRequests;
+	for (int i = 0; i < 2; i++)
+	{
+		Http(options).post(server.url, body, "application/json");
+		ASSERT_NE(std::string::npos, request.find("Content-Encoding: gzip\r\n"));
+		size_t end = request.find("\r\n\r\n") + 4;
+		ASSERT_LT(request.size() - end, body.size());
+		ASSERT_EQ(body, gunzip(request.substr(end)));
+	}
+	ASSERT_EQ(compressed + 2, Http::getStats().compressedRequests);
+
+	// below the threshold
+	Http(options).post(server.url, "{\"small\":true}", "application/json");
+	ASSERT_EQ(std::string::npos, request.find("Content-Encoding"));
+	ASSERT_NE(std::string::npos, request.find("\r\n\r\n{\"small\":true}"));
+
+	Config config;
+	config["compress-requests"] = { "gzip" };
+	config["compress-min-size"] = { "512" };
+	HttpOptions loaded;
+	loaded.load(config);
+	ASSERT_TRUE(loaded.gzip);
+	ASSERT_EQ(512, loaded.gzipMinSize);
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "../src/jsonwriter.h"
+#include "json.hpp"
+
+class JsonWriterTest : public ::testing::Test {
+protected:
+	std::string buffer;
+};
+
+TEST_F(JsonWriterTest, empty)
+{
+	JsonWriter(buffer).beginObject().endObject();
+	ASSERT_EQ("{}", buffer);
+	JsonWriter(buffer).beginArray().endArray();
+	ASSERT_EQ("[]", buffer);
+}
+
+TEST_F(JsonWriterTest, values)
+{
+	JsonWriter writer(buffer);
+	writer.beginObject()
+		.field("s", "text")
+		.field("i", -42)
+		.field("l", (int64_t)1767225600123)
+		.field("b", true)
+		.key("a").beginArray()
+			.value(1)
+			.value("two")
+			.beginObject().endObject()
+			.beginArray().value(false).endArray()
+		.endArray()
+		.key("o").beginObject()
+			.field("x", 0)
+		.endObject()
+	.endObject();
+	ASSERT_EQ(R"({"s":"text","i":-42,"l":1767225600123,"b":true,"a":[1,"two",{},[false]],"o":{"x":0}})", buffer);
+}
+
+TEST_F(JsonWriterTest, reuse)
+{
+	JsonWriter(buffer).beginArray().value(1).endArray();
+	JsonWriter(buffer).beginArray().value(2).endArray();
+	ASSERT_EQ("[2]", buffer);
+}
+
+TEST_F(JsonWriterTest, escape)
+{
+	JsonWriter(buffer).value("a\"b\\c\nd\te\x01\x1f/");
+	ASSERT_EQ(R"("a\"b\\c\nd\te\u0001\u001f/")", buffer);
+	// valid UTF-8
+	JsonWriter(buffer).value("caf\xc3\xa9 \xe3\x81\x82 \xf0\x9f\x8e\xae");
+	ASSERT_EQ("\"caf\xc3\xa9 \xe3\x81\x82 \xf0\x9f\x8e\xae\"", buffer);
+	// invalid UTF-8
+	JsonWriter(buffer).value("a\xff" "b\xc3" "c\xe3\x81" "d\xed\xa0\x80");
+	ASSERT_EQ("\"a\xef\xbf\xbd" "b\xef\xbf\xbd" "c\xef\xbf\xbd\xef\xbf\xbd" "d\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"", buffer);
+}
+
+TEST_F(JsonWriterTest, parse)
+{
+	std::string s;
+	for (int c = 1; c < 256; c++)
+		s += (char)c;
+	JsonWriter(buffer).beginObject().field("key", s).endObject();
+	nlohmann::json json = nlohmann::json::parse(buffer);
+	std::string expected = nlohmann::json(s).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+	ASSERT_EQ(nlohmann::json::parse(expected), json["key"]);
+}
@@ -0,0 +1,32 @@
+#include "gtest/gtest.h"
+#include "../src/messageids.h"
+#include <unistd.h>
+
+class MessageIdsTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		unlink("messages.db");
+	}
+};
+
+TEST_F(MessageIdsTest, getSet)
+{
+	{
+		MessageIds ids("messages.db");
+		ASSERT_EQ("", ids.get("https://webhook", "game"));
+		ids.set("https://webhook", "game", "123");
+		ids.set("https://webhook", "other", "456");
+		ids.set("https://webhook2", "game", "789");
+		ASSERT_EQ("123", ids.get("https://webhook", "game"));
+		ids.set("https://webhook", "game", "124");
+		ASSERT_EQ("124", ids.get("https://webhook", "game"));
+	}
+	// persistent
+	MessageIds ids("messages.db");
+	ASSERT_EQ("124", ids.get("https://webhook", "game"));
+	ASSERT_EQ("456", ids.get("https://webhook", "other"));
+	ASSERT_EQ("789", ids.get("https://webhook2", "game"));
+	ids.remove("https://webhook", "game");
+	ASSERT_EQ("", ids.get("https://webhook", "game"));
+	ASSERT_EQ("456", ids.get("https://webhook", "other"));
+}
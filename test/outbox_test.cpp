@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "../src/outbox.h"
+#include <unistd.h>
+
+class OutboxTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		unlink("outbox.db");
+	}
+
+	const std::vector<std::string> urls { "https://webhook" };
+};
+
+TEST_F(OutboxTest, empty)
+{
+	Outbox outbox("outbox.db");
+	ASSERT_EQ(-1, outbox.nextAttempt(urls));
+	ASSERT_TRUE(outbox.claim(urls, 1000, 60, 10).empty());
+}
+
+TEST_F(OutboxTest, storeAndDeliver)
+{
+	Outbox outbox("outbox.db");
+	std::vector<int64_t> ids = outbox.store("https://webhook", { "{\"a\":1}", "{\"b\":2}" }, 100);
+	ASSERT_EQ(2, ids.size());
+	ASSERT_EQ(100, outbox.nextAttempt(urls));
+	ASSERT_TRUE(outbox.claim(urls, 99, 60, 10).empty());
+
+	ASSERT_EQ(1, outbox.claim(urls, 100, 0, 1).size());
+	std::vector<Outbox::Entry> due = outbox.claim(urls, 100, 60, 10);
+	ASSERT_EQ(2, due.size());
+	ASSERT_EQ(ids[0], due[0].id);
+	ASSERT_EQ("https://webhook", due[0].url);
+	ASSERT_EQ("{\"a\":1}", due[0].payload);
+	ASSERT_EQ(0, due[0].attempts);
+	ASSERT_EQ("{\"b\":2}", due[1].payload);
+	// leased
+	ASSERT_TRUE(outbox.claim(urls, 159, 60, 10).empty());
+	ASSERT_EQ(160, outbox.nextAttempt(urls));
+
+	outbox.remove(ids[0]);
+	outbox.reschedule(ids[1], 3, 200);
+	ASSERT_TRUE(outbox.claim(urls, 199, 60, 10).empty());
+	due = outbox.claim(urls, 200, 60, 10);
+	ASSERT_EQ(1, due.size());
+	ASSERT_EQ(3, due[0].attempts);
+	outbox.remove(ids[1]);
+	ASSERT_EQ(-1, outbox.nextAttempt(urls));
+}
+
+TEST_F(OutboxTest, persistent)
+{
+	{
+		Outbox outbox("outbox.db");
+		outbox.store("https://webhook", { "payload" }, 100);
+	}
+	Outbox outbox("outbox.db");
+	std::vector<Outbox::Entry> due = outbox.claim(urls, 100, 60, 10);
+	ASSERT_EQ(1, due.size());
+	ASSERT_EQ("payload", due[0].payload);
+}
+
+TEST_F(OutboxTest, sharedDatabase)
+{
+	Outbox outbox1("outbox.db");
+	Outbox outbox2("outbox.db");
+	outbox1.store("https://webhook", { "payload" }, 100);
+	outbox1.store("https://other", { "other" }, 100);
+	// only claimed once
+	std::vector<Outbox::Entry> due = outbox2.claim(urls, 100, 60, 10);
+	ASSERT_EQ(1, due.size());
+	ASSERT_EQ("payload", due[0].payload);
+	ASSERT_TRUE(outbox1.claim(urls, 100, 60, 10).empty());
+	// messages of unknown webhooks are left alone
+	ASSERT_EQ(160, outbox1.nextAttempt(urls));
+	ASSERT_EQ(100, outbox1.nextAttempt({ "https://other" }));
+	ASSERT_TRUE(outbox1.claim({}, 100, 60, 10).empty());
+}
+
+TEST_F(OutboxTest, backoff)
+{
+	ASSERT_EQ(5, Outbox::backoff(1));
+	ASSERT_EQ(10, Outbox::backoff(2));
+	ASSERT_EQ(20, Outbox::backoff(3));
+	ASSERT_EQ(2560, Outbox::backoff(10));
+	ASSERT_EQ(3600, Outbox::backoff(11));
+	ASSERT_EQ(3600, Outbox::backoff(100));
+}
@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "../src/ratelimit.h"
+
+using namespace std::chrono;
+
+class RateLimitTest : public ::testing::Test {
+protected:
+	RateLimiter::clock::time_point t0 = RateLimiter::clock::now();
+};
+
+TEST_F(RateLimitTest, defaultBucket)
+{
+	RateLimiter limiter(5, seconds(2));
+	for (int i = 0; i < 5; i++)
+		ASSERT_EQ(t0, limiter.acquire(t0));
+	ASSERT_EQ(t0 + seconds(2), limiter.acquire(t0));
+	ASSERT_EQ(t0 + seconds(2), limiter.acquire(t0 + seconds(1)));
+	// new window
+	ASSERT_EQ(t0 + seconds(2), limiter.acquire(t0 + seconds(2)));
+}
+
+TEST_F(RateLimitTest, headers)
+{
+	RateLimiter limiter(5, seconds(2));
+	ASSERT_EQ(t0, limiter.acquire(t0));
+	// the server says we only have one request left for 500 ms
+	limiter.update(5, 1, 0.5, t0);
+	ASSERT_EQ(t0, limiter.acquire(t0));
+	ASSERT_EQ(t0 + milliseconds(500), limiter.acquire(t0));
+	ASSERT_EQ(t0 + milliseconds(500), limiter.acquire(t0 + milliseconds(500)));
+	// missing headers
+	limiter.update(-1, -1, -1.0, t0 + milliseconds(500));
+	ASSERT_EQ(t0 + milliseconds(500), limiter.acquire(t0 + milliseconds(500)));
+}
+
+TEST_F(RateLimitTest, tooManyRequests)
+{
+	RateLimiter limiter(5, seconds(2));
+	ASSERT_EQ(t0, limiter.acquire(t0));
+	limiter.block(10.0, t0);
+	ASSERT_EQ(t0 + seconds(10), limiter.acquire(t0 + seconds(1)));
+	ASSERT_EQ(t0 + seconds(10), limiter.acquire(t0 + seconds(10)));
+}
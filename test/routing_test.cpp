@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+#include "../src/routing.h"
+#include <sstream>
+
+class RoutingTest : public ::testing::Test {
+protected:
+	RoutingTable load(const std::string& s) {
+		std::stringstream stream(s);
+		Config config = loadConfig(stream);
+		RoutingTable routing;
+		routing.load(config);
+		return routing;
+	}
+};
+
+TEST_F(RoutingTest, empty)
+{
+	RoutingTable routing = load("");
+	ASSERT_EQ(RoutingTable::NoRoute, routing.route("chuchu"));
+	ASSERT_TRUE(routing.webhooks().empty());
+}
+
+TEST_F(RoutingTest, defaultWebhook)
+{
+	RoutingTable routing = load("webhook=https://default\n");
+	ASSERT_EQ(1, routing.webhooks().size());
+	ASSERT_EQ("https://default", routing.webhooks()[routing.route("chuchu")]);
+}
+
+TEST_F(RoutingTest, routes)
+{
+	RoutingTable routing = load("webhook=https://default\n"
+			"webhook.chuchu=https://chuchu\n"
+			"group.sega=afo, chuchu, pso\n"
+			"webhook.sega=https://sega\n"
+			"webhook.bomberman=https://default\n");
+	ASSERT_EQ(3, routing.webhooks().size());
+	const auto& urls = routing.webhooks();
+	ASSERT_EQ("https://chuchu", urls[routing.route("chuchu")]);
+	ASSERT_EQ("https://sega", urls[routing.route("afo")]);
+	ASSERT_EQ("https://sega", urls[routing.route("pso")]);
+	ASSERT_EQ("https://default", urls[routing.route("bomberman")]);
+	ASSERT_EQ("https://default", urls[routing.route("unknown")]);
+}
+
+TEST_F(RoutingTest, noDefault)
+{
+	RoutingTable routing = load("group.sega=afo, pso\n"
+			"webhook.sega=https://sega\n");
+	ASSERT_EQ("https://sega", routing.webhooks()[routing.route("afo")]);
+	ASSERT_EQ(RoutingTable::NoRoute, routing.route("chuchu"));
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "../src/sink.h"
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+class SinkTest : public ::testing::Test {
+protected:
+	static std::vector<PendingNotif> batch(int count)
+	{
+		std::vector<PendingNotif> batch;
+		for (int i = 0; i < count; i++)
+		{
+			PendingNotif p;
+			p.gameId = "chuchu";
+			p.notif.content = "content " + std::to_string(i);
+			p.notif.embed.title = "title";
+			p.notif.embed.text = "text";
+			batch.push_back(p);
+		}
+		return batch;
+	}
+};
+
+TEST_F(SinkTest, create)
+{
+	ASSERT_NE(nullptr, dynamic_cast<DiscordSink *>(createSink("https://discord.com/api/webhooks/1/x", RetryPolicy()).get()));
+	ASSERT_NE(nullptr, dynamic_cast<JsonSink *>(createSink("json:https://example.com/hook", RetryPolicy()).get()));
+	ASSERT_NE(nullptr, dynamic_cast<FileSink *>(createSink("file:/tmp/notifs.log", RetryPolicy()).get()));
+	ASSERT_NE(nullptr, dynamic_cast<SyslogSink *>(createSink("syslog", RetryPolicy()).get()));
+	ASSERT_NE(nullptr, dynamic_cast<SyslogSink *>(createSink("syslog:dcnet", RetryPolicy()).get()));
+	ASSERT_NE(nullptr, dynamic_cast<MemorySink *>(createSink("memory:test", RetryPolicy()).get()));
+	ASSERT_TRUE(createSink("https://discord.com/api/webhooks/1/x", RetryPolicy())->persistent());
+	ASSERT_FALSE(createSink("memory:test", RetryPolicy())->persistent());
+}
+
+TEST_F(SinkTest, discordLimits)
+{
+	DiscordSink sink { RetryPolicy() };
+	std::vector<std::string> payloads;
+	sink.serialize(batch(12), payloads);
+	// at most 10 embeds per message
+	ASSERT_EQ(2u, payloads.size());
+	ASSERT_NE(std::string::npos, payloads[0].find("\"content\":\"content 0\\ncontent 1\\n"));
+	ASSERT_NE(std::string::npos, payloads[1].find("\"content\":\"content 10\\ncontent 11\""));
+	sink.serialize(batch(1), payloads);
+	ASSERT_EQ(1u, payloads.size());
+}
+
+TEST_F(SinkTest, memory)
+{
+	std::unique_ptr<Sink> sink = createSink("memory:test", RetryPolicy());
+	Dispatcher::Route route(0, "memory:test", 16);
+	std::vector<std::string> payloads;
+	sink->serialize(batch(2), payloads);
+	ASSERT_EQ(1u, payloads.size());
+	sink->send(route, payloads[0]);
+	std::vector<std::string> sent = MemorySink::take("test");
+	ASSERT_EQ(1u, sent.size());
+	ASSERT_EQ(0u, sent[0].find("{\"notifications\":[{\"gameId\":\"chuchu\",\"game\":\"ChuChu Rocket!\","));
+	ASSERT_NE(std::string::npos, sent[0].find("\"priority\":\"normal\",\"content\":\"content 1\",\"title\":\"title\",\"text\":\"text\"}]}"));
+	ASSERT_TRUE(MemorySink::take("test").empty());
+}
+
+TEST_F(SinkTest, file)
+{
+	unlink("notifs.log");
+	std::unique_ptr<Sink> sink = createSink("file:notifs.log", RetryPolicy());
+	Dispatcher::Route route(0, "file:notifs.log", 16);
+	std::vector<std::string> payloads;
+	sink->serialize(batch(2), payloads);
+	for (const auto& payload : payloads)
+		sink->send(route, payload);
+	sink->serialize(batch(1), payloads);
+	for (const auto& payload : payloads)
+		sink->send(route, payload);
+	std::ifstream file("notifs.log");
+	std::string line;
+	int lines = 0;
+	while (std::getline(file, line)) {
+		ASSERT_EQ('{', line.front());
+		ASSERT_EQ('}', line.back());
+		lines++;
+	}
+	ASSERT_EQ(3, lines);
+}
+
+TEST_F(SinkTest, cancelRateLimitWait)
+{
+	CancelToken token;
+	HttpOptions options;
+	options.cancelToken = &token;
+	Dispatcher::Route route(0, "http://127.0.0.1:1/", 1);
+	// rate limited for a minute
+	route.rateLimiter.block(60);
+	std::thread canceller([&token]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		token.cancel();
+	});
+	auto start = std::chrono::steady_clock::now();
+	try {
+		sendRateLimited(route, route.url, "{}", RetryPolicy(), options);
+		FAIL();
+	} catch (const CurlError& e) {
+		ASSERT_TRUE(e.cancelled());
+	}
+	canceller.join();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
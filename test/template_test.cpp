@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "../src/template.h"
+#include <sstream>
+
+class TemplateTest : public ::testing::Test {
+protected:
+	static std::string render(std::string_view source, std::initializer_list<TemplateArg> args)
+	{
+		std::string out;
+		MessageTemplate(source).render(out, args.begin(), args.size());
+		return out;
+	}
+};
+
+TEST_F(TemplateTest, placeholders)
+{
+	ASSERT_EQ("", render("", {}));
+	ASSERT_EQ("no placeholder", render("no placeholder", {}));
+	ASSERT_EQ("hello **j\\_doe**!", render("hello **{name}**!", { { "name", "j_doe" } }));
+	ASSERT_EQ("j_doe", render("{name:raw}", { { "name", "j_doe" } }));
+	ASSERT_EQ("3 players", render("{count:int} players", { { "count", 3 } }));
+	ASSERT_EQ("-12 players", render("{count:int} players", { { "count", "-12" } }));
+	ASSERT_EQ("0", render("{count:int}", { { "count", "abc" } }));
+	ASSERT_EQ("42", render("{count}", { { "count", (int64_t)42 } }));
+	ASSERT_EQ("a b", render("{a} {b}", { { "b", "b" }, { "a", "a" } }));
+	// missing argument
+	ASSERT_EQ("[]", render("[{missing}]", {}));
+	ASSERT_EQ("{literal}\nback\\slash", render("{{literal}}\\nback\\\\slash", {}));
+}
+
+TEST_F(TemplateTest, invalid)
+{
+	ASSERT_THROW(MessageTemplate("{unterminated"), std::runtime_error);
+	ASSERT_THROW(MessageTemplate("{}"), std::runtime_error);
+	ASSERT_THROW(MessageTemplate("{name:float}"), std::runtime_error);
+}
+
+TEST_F(TemplateTest, reuseBuffer)
+{
+	MessageTemplate tmpl("{player} joined lobby {lobby:int}");
+	std::string out;
+	TemplateArg args[] { { "player", "someone with a long name" }, { "lobby", 1 } };
+	tmpl.render(out, args, 2);
+	ASSERT_EQ("someone with a long name joined lobby 1", out);
+	const char *data = out.data();
+	args[0] = { "player", "bob" };
+	tmpl.render(out, args, 2);
+	ASSERT_EQ("bob joined lobby 1", out);
+	ASSERT_EQ(data, out.data());
+}
+
+TEST_F(TemplateTest, templateSet)
+{
+	std::istringstream stream(
+		"# comment\n"
+		"joined.content = {player} joined, welcome!\n"
+		"joined.title = Player joined\n"
+		"pso.joined.title = Hunter joined\n"
+		"pso.joined.text = {player} is in {lobby}\n"
+		"bad.content = {oops\n"
+		"nofield = x\n"
+		"chuchu.joined.colour = red\n");
+	TemplateSet templates;
+	templates.load(stream);
+	ASSERT_EQ(nullptr, templates.find("pso", "bad"));
+	ASSERT_EQ(nullptr, templates.find("pso", "left"));
+	// an unknown field doesn't hide the default template
+	ASSERT_EQ(templates.find("", "joined"), templates.find("chuchu", "joined"));
+
+	TemplateArg args[] { { "player", "a*b" }, { "lobby", "Ragol" } };
+	Notif notif;
+	ASSERT_TRUE(templates.render("chuchu", "joined", args, 2, notif));
+	ASSERT_EQ("a\\*b joined, welcome!", notif.content);
+	ASSERT_EQ("Player joined", notif.embed.title);
+	ASSERT_EQ("", notif.embed.text);
+	// game specific template
+	ASSERT_TRUE(templates.render("pso", "joined", args, 2, notif));
+	ASSERT_EQ("", notif.content);
+	ASSERT_EQ("Hunter joined", notif.embed.title);
+	ASSERT_EQ("a\\*b is in Ragol", notif.embed.text);
+	ASSERT_FALSE(templates.render("pso", "left", args, 2, notif));
+}
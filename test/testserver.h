@@ -0,0 +1,113 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Listening socket on a random loopback port, or on a unix domain socket if a path is given
+class TestSocket
+{
+public:
+	TestSocket(const std::string& unixPath = {})
+	{
+		if (!unixPath.empty())
+		{
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			sockaddr_un addr {};
+			addr.sun_family = AF_UNIX;
+			unixPath.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+			unlink(unixPath.c_str());
+			bind(fd, (sockaddr *)&addr, sizeof(addr));
+			listen(fd, 4);
+			url = "http://localhost/";
+			return;
+		}
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in addr {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		bind(fd, (sockaddr *)&addr, sizeof(addr));
+		listen(fd, 4);
+		socklen_t len = sizeof(addr);
+		getsockname(fd, (sockaddr *)&addr, &len);
+		url = "http://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) + "/";
+	}
+	~TestSocket() {
+		close(fd);
+	}
+
+	std::string url;
+
+protected:
+	int fd;
+};
+
+// Accepts connections in its backlog but never answers
+using SilentServer = TestSocket;
+
+// Answers each request with the response returned by the handler
+class TestServer : public TestSocket
+{
+public:
+	// Returns the status line, headers and body
+	using Handler = std::function<std::string(const std::string& request)>;
+
+	TestServer(Handler handler, const std::string& unixPath = {})
+		: TestSocket(unixPath), handler(handler)
+	{
+		thread = std::thread([this]() {
+			int client;
+			while ((client = accept(fd, nullptr, nullptr)) >= 0)
+			{
+				std::string request = readRequest(client);
+				std::string response = this->handler(request);
+				(void)!write(client, response.data(), response.size());
+				close(client);
+			}
+		});
+	}
+	~TestServer() {
+		shutdown(fd, SHUT_RDWR);
+		thread.join();
+	}
+
+	static std::string response(const std::string& status, const std::string& headers, const std::string& body) {
+		return "HTTP/1.1 " + status + "\r\n" + headers + "Connection: close\r\nContent-Length: "
+				+ std::to_string(body.size()) + "\r\n\r\n" + body;
+	}
+
+private:
+	static std::string readRequest(int client)
+	{
+		std::string request;
+		char buf[4096];
+		ssize_t n;
+		size_t end;
+		while ((end = request.find("\r\n\r\n")) == std::string::npos && (n = read(client, buf, sizeof(buf))) > 0)
+			request.append(buf, n);
+		if (end == std::string::npos)
+			return request;
+		size_t length = 0;
+		size_t pos = request.find("Content-Length: ");
+		if (pos != std::string::npos && pos < end)
+			length = std::stoul(request.substr(pos + 16));
+		while (request.size() < end + 4 + length && (n = read(client, buf, sizeof(buf))) > 0)
+			request.append(buf, n);
+		return request;
+	}
+
+	Handler handler;
+	std::thread thread;
+};
+
+// Answers each request with the same body
+class StaticServer : public TestServer
+{
+public:
+	StaticServer(const std::string& body)
+		: TestServer([body](const std::string&) { return response("200 OK", "X-Test: Value \r\n", body); }) {}
+};
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "../src/wordfilter.h"
+#include <sstream>
+
+class WordFilterTest : public ::testing::Test {
+protected:
+	static std::string mask(const WordFilter& filter, std::string_view str)
+	{
+		std::string out;
+		if (!filter.mask(str, out))
+			return std::string(str);
+		return out;
+	}
+	static std::string maskEscaped(const WordFilter& filter, std::string_view str)
+	{
+		std::string out;
+		if (!filter.maskEscaped(str, out))
+			return std::string(str);
+		return out;
+	}
+};
+
+TEST_F(WordFilterTest, empty)
+{
+	WordFilter filter;
+	ASSERT_TRUE(filter.empty());
+	std::string out = "untouched";
+	ASSERT_FALSE(filter.mask("anything", out));
+	ASSERT_EQ("untouched", out);
+}
+
+TEST_F(WordFilterTest, mask)
+{
+	WordFilter filter({ "he", "she", "his", "hers", "Noob" });
+	ASSERT_EQ("nothing to sea", mask(filter, "nothing to sea"));
+	ASSERT_EQ("****", mask(filter, "hers"));
+	ASSERT_EQ("u*****", mask(filter, "ushers"));
+	ASSERT_EQ("t*** ****", mask(filter, "this NOOB"));
+	ASSERT_EQ("a ***** b", mask(filter, "a hishe b"));
+	ASSERT_EQ("", mask(filter, ""));
+}
+
+TEST_F(WordFilterTest, utf8)
+{
+	WordFilter filter({ "\xe3\x81\xb0\xe3\x81\x8b" });	// ばか
+	ASSERT_EQ("x******y", mask(filter, "x\xe3\x81\xb0\xe3\x81\x8by"));
+	ASSERT_EQ("\xe3\x81\xb0", mask(filter, "\xe3\x81\xb0"));
+}
+
+TEST_F(WordFilterTest, load)
+{
+	std::istringstream stream("# banned words\n\n  badword  \nugly\n");
+	WordFilter filter = WordFilter::load(stream);
+	ASSERT_FALSE(filter.empty());
+	ASSERT_EQ("a ******* and **** one", mask(filter, "a BadWord and ugly one"));
+}
+
+TEST_F(WordFilterTest, maskEscaped)
+{
+	WordFilter filter({ "sh_t", "b*d", "noob" });
+	// discordEscape("sh_t is b*d")
+	ASSERT_EQ("\\*\\*\\*\\* is \\*\\*\\*", maskEscaped(filter, "sh\\_t is b\\*d"));
+	// the mask doesn't turn into markdown
+	ASSERT_EQ("**\\*\\*\\*\\***", maskEscaped(filter, "**noob**"));
+	ASSERT_EQ("a \\\\ b", maskEscaped(filter, "a \\\\ b"));
+	// not escaped
+	ASSERT_EQ("\\*\\*\\*\\*!", maskEscaped(filter, "sh_t!"));
+}
@@ -0,0 +1,153 @@
+/*
+	Utility library for Dreamcast game servers.
+    Copyright (C) 2026  Flyinghead
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// Generates a C++ header containing the games of games.json and
+// a perfect hash table indexing them.
+//
+#include "../src/hash.h"
+#include "json.hpp"
+#include <fstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace nlohmann;
+
+struct Game
+{
+	std::string id;
+	std::string name;
+	std::string thumbnail;
+};
+
+static std::string literal(const std::string& s)
+{
+	std::string out = "\"";
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		}
+		else if ((uint8_t)c < 0x20 || (uint8_t)c >= 0x80) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\%03o", (uint8_t)c);
+			out += buf;
+		}
+		else {
+			out += c;
+		}
+	}
+	return out + '"';
+}
+
+// Finds a hash function basis and table size without collisions
+static bool findPerfectHash(const std::vector<Game>& games, uint64_t& basis, size_t& slotCount)
+{
+	for (slotCount = 4; slotCount < games.size() * 2; slotCount <<= 1)
+		;
+	for (; slotCount <= 65536; slotCount <<= 1)
+	{
+		for (uint64_t seed = 0; seed < 100000; seed++)
+		{
+			basis = FNV_OFFSET_BASIS ^ (seed * 0x9e3779b97f4a7c15ull);
+			std::vector<bool> used(slotCount);
+			bool collision = false;
+			for (const Game& game : games)
+			{
+				size_t slot = hashSlot(fnv1a(game.id, basis), slotCount);
+				if (used[slot]) {
+					collision = true;
+					break;
+				}
+				used[slot] = true;
+			}
+			if (!collision)
+				return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <games.json> <output.h>\n", argv[0]);
+		return 1;
+	}
+	std::ifstream ifs(argv[1]);
+	if (ifs.fail()) {
+		perror(argv[1]);
+		return 1;
+	}
+	std::vector<Game> games;
+	try {
+		json jgames = json::parse(ifs);
+		for (const auto& [id, game] : jgames.items())
+		{
+			auto name = game.find("name");
+			auto thumbnail = game.find("thumbnail");
+			if (name == game.end() || !name->is_string() || thumbnail == game.end() || !thumbnail->is_string()) {
+				fprintf(stderr, "%s: invalid entry %s\n", argv[1], id.c_str());
+				return 1;
+			}
+			games.push_back({ id, name->get<std::string>(), thumbnail->get<std::string>() });
+		}
+	} catch (const json::exception& e) {
+		fprintf(stderr, "%s: %s\n", argv[1], e.what());
+		return 1;
+	}
+	uint64_t basis;
+	size_t slotCount;
+	if (!findPerfectHash(games, basis, slotCount)) {
+		fprintf(stderr, "Can't find a perfect hash function\n");
+		return 1;
+	}
+
+	FILE *f = fopen(argv[2], "w");
+	if (f == nullptr) {
+		perror(argv[2]);
+		return 1;
+	}
+	fprintf(f, "// Generated from games.json by gengames. Do not edit.\n");
+	fprintf(f, "#pragma once\n");
+	fprintf(f, "#include \"games.hpp\"\n");
+	fprintf(f, "#include <cstdint>\n\n");
+	fprintf(f, "namespace builtin {\n\n");
+	fprintf(f, "constexpr uint64_t HASH_BASIS = 0x%llxull;\n", (unsigned long long)basis);
+	fprintf(f, "constexpr size_t SLOT_COUNT = %zu;\n\n", slotCount);
+	fprintf(f, "constexpr GameInfo games[] = {\n");
+	for (const Game& game : games)
+		fprintf(f, "\t{ %s, %s, %s },\n", literal(game.id).c_str(), literal(game.name).c_str(),
+				literal(game.thumbnail).c_str());
+	if (games.empty())
+		fprintf(f, "\t{},\n");
+	fprintf(f, "};\n\n");
+	std::vector<unsigned> slots(slotCount);
+	for (size_t i = 0; i < games.size(); i++)
+		slots[hashSlot(fnv1a(games[i].id, basis), slotCount)] = i + 1;
+	fprintf(f, "// index + 1 into games, 0 if empty\n");
+	fprintf(f, "constexpr uint16_t slots[SLOT_COUNT] = {");
+	for (size_t i = 0; i < slotCount; i++)
+		fprintf(f, "%s%u,", i % 16 == 0 ? "\n\t" : " ", slots[i]);
+	fprintf(f, "\n};\n\n");
+	fprintf(f, "} // namespace builtin\n");
+	fclose(f);
+
+	return 0;
+}
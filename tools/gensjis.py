@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+#
+# Generates src/sjis_table.h, the Shift-JIS (Windows code page 932) double-byte table
+# used by src/encoding.cpp.
+# Usage: tools/gensjis.py > src/sjis_table.h
+#
+LEADS = list(range(0x81, 0xA0)) + list(range(0xE0, 0xFD))
+TRAIL_FIRST = 0x40
+TRAIL_LAST = 0xFC
+
+print("// Generated by tools/gensjis.py. Do not edit.")
+print("#pragma once")
+print("#include <cstdint>")
+print()
+print("namespace sjis {")
+print()
+print("constexpr unsigned TRAIL_FIRST = 0x%02x;" % TRAIL_FIRST)
+print("constexpr unsigned TRAIL_COUNT = %d;" % (TRAIL_LAST - TRAIL_FIRST + 1))
+print()
+print("// Index + 1 of each lead byte in table, 0 if not a lead byte")
+print("constexpr uint8_t leadIndex[256] = {")
+index = [0] * 256
+for i, lead in enumerate(LEADS):
+    index[lead] = i + 1
+for row in range(0, 256, 16):
+    print("\t" + ", ".join(str(v) for v in index[row:row + 16]) + ",")
+print("};")
+print()
+print("// BMP code point of each lead and trail byte pair, 0 if unmapped")
+print("constexpr uint16_t table[%d][TRAIL_COUNT] = {" % len(LEADS))
+for lead in LEADS:
+    codes = []
+    for trail in range(TRAIL_FIRST, TRAIL_LAST + 1):
+        try:
+            c = bytes([lead, trail]).decode("cp932")
+            codes.append(ord(c) if len(c) == 1 and ord(c) <= 0xFFFF else 0)
+        except UnicodeDecodeError:
+            codes.append(0)
+    print("\t{ // 0x%02X" % lead)
+    for row in range(0, len(codes), 16):
+        print("\t\t" + ", ".join("0x%04x" % v for v in codes[row:row + 16]) + ",")
+    print("\t},")
+print("};")
+print()
+print("}")